@@ -45,6 +45,8 @@
 #include <math.h>
 #include <iostream>
 #include <stdio.h>
+#include <vector>
+#include <algorithm>
 #include "glwidget.h"
 #include "mainwindow.h"
 
@@ -53,6 +55,12 @@ using namespace std;
 #define MY_PI 3.14159265
 #define ZSHIFT -5.0
 
+// Surfaces with more triangles than LOD_LIMIT get a decimated copy of about
+// LOD_TRIANGLES triangles that is drawn while the view is being rotated.
+#define LOD_LIMIT 1000000
+#define LOD_TRIANGLES 250000
+#define LOD_TIMEOUT 300
+
 // Get qreal regardless of whether it's float or double
 static inline void glGetQrealv(GLenum e, GLfloat* data) { glGetFloatv(e,data); }
 static inline void glGetQrealv(GLenum e, GLdouble* data) { glGetDoublev(e,data); }
@@ -64,7 +72,11 @@ list_t::list_t()
   nature = PDE_UNKNOWN;
   type = UNKNOWNLIST;
   index = -1;
-  object = 0;
+  first = 0;
+  count = 0;
+  lodFirst = 0;
+  lodCount = 0;
+  color = Qt::black;
   child = -1;
   parent = -1;
   selected = false;
@@ -105,14 +117,46 @@ int list_t::getIndex(void) const
   return this->index;
 }
 
-void list_t::setObject(GLuint n)
+void list_t::setRange(int first, int count)
+{
+  this->first = first;
+  this->count = count;
+}
+
+int list_t::getFirst(void) const
+{
+  return this->first;
+}
+
+int list_t::getCount(void) const
+{
+  return this->count;
+}
+
+void list_t::setLodRange(int first, int count)
 {
-  this->object = n;
+  this->lodFirst = first;
+  this->lodCount = count;
 }
 
-GLuint list_t::getObject(void) const
+int list_t::getLodFirst(void) const
 {
-  return this->object;
+  return this->lodFirst;
+}
+
+int list_t::getLodCount(void) const
+{
+  return this->lodCount;
+}
+
+void list_t::setColor(QColor c)
+{
+  this->color = c;
+}
+
+QColor list_t::getColor(void) const
+{
+  return this->color;
 }
 
 void list_t::setChild(int n)
@@ -155,6 +199,164 @@ bool list_t::isVisible(void) const
   return this->visible;
 }
 
+meshArray_t::meshArray_t()
+  : vertexBuffer(QGLBuffer::VertexBuffer),
+    normalBuffer(QGLBuffer::VertexBuffer),
+    colorBuffer(QGLBuffer::VertexBuffer),
+    indexBuffer(QGLBuffer::IndexBuffer)
+{
+  buffered = false;
+  normals = false;
+  colors = false;
+}
+
+meshArray_t::~meshArray_t()
+{
+}
+
+// Drop the data, the GL context must be current
+void meshArray_t::clear()
+{
+  vertex = QVector<GLfloat>();
+  normal = QVector<GLfloat>();
+  color = QVector<GLfloat>();
+  index = QVector<GLuint>();
+
+  vertexBuffer.destroy();
+  normalBuffer.destroy();
+  colorBuffer.destroy();
+  indexBuffer.destroy();
+
+  buffered = false;
+  normals = false;
+  colors = false;
+}
+
+// Move the data to buffer objects if the driver has them. Otherwise the
+// data is kept and drawn from client side arrays.
+void meshArray_t::upload()
+{
+  normals = !normal.isEmpty();
+  colors = !color.isEmpty();
+  buffered = false;
+
+  if(vertex.isEmpty())
+    return;
+
+  if(!vertexBuffer.create())
+    return;
+
+  if(normals && !normalBuffer.create())
+    return;
+
+  if(colors && !colorBuffer.create())
+    return;
+
+  if(!index.isEmpty() && !indexBuffer.create())
+    return;
+
+  vertexBuffer.bind();
+  vertexBuffer.allocate(vertex.constData(), vertex.size() * sizeof(GLfloat));
+  vertex = QVector<GLfloat>();
+  
+  if(normals) {
+    normalBuffer.bind();
+    normalBuffer.allocate(normal.constData(), normal.size() * sizeof(GLfloat));
+    normal = QVector<GLfloat>();
+  }
+
+  if(colors) {
+    colorBuffer.bind();
+    colorBuffer.allocate(color.constData(), color.size() * sizeof(GLfloat));
+    color = QVector<GLfloat>();
+  }
+
+  QGLBuffer::release(QGLBuffer::VertexBuffer);
+
+  if(!index.isEmpty()) {
+    indexBuffer.bind();
+    indexBuffer.allocate(index.constData(), index.size() * sizeof(GLuint));
+    index = QVector<GLuint>();
+    QGLBuffer::release(QGLBuffer::IndexBuffer);
+  }
+
+  buffered = true;
+}
+
+void meshArray_t::bind()
+{
+  glEnableClientState(GL_VERTEX_ARRAY);
+
+  if(buffered) {
+    vertexBuffer.bind();
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+  } else {
+    glVertexPointer(3, GL_FLOAT, 0, vertex.constData());
+  }
+
+  if(normals) {
+    glEnableClientState(GL_NORMAL_ARRAY);
+    if(buffered) {
+      normalBuffer.bind();
+      glNormalPointer(GL_FLOAT, 0, 0);
+    } else {
+      glNormalPointer(GL_FLOAT, 0, normal.constData());
+    }
+  }
+
+  if(colors) {
+    if(buffered) {
+      colorBuffer.bind();
+      glColorPointer(3, GL_FLOAT, 0, 0);
+    } else {
+      glColorPointer(3, GL_FLOAT, 0, color.constData());
+    }
+  }
+
+  if(buffered) {
+    QGLBuffer::release(QGLBuffer::VertexBuffer);
+    if(indexBuffer.isCreated())
+      indexBuffer.bind();
+  }
+}
+
+void meshArray_t::release()
+{
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  if(buffered)
+    QGLBuffer::release(QGLBuffer::IndexBuffer);
+}
+
+// Per vertex colors override the current color
+void meshArray_t::enableColors(bool b)
+{
+  if(b && colors)
+    glEnableClientState(GL_COLOR_ARRAY);
+  else
+    glDisableClientState(GL_COLOR_ARRAY);
+}
+
+void meshArray_t::drawArrays(GLenum mode, int first, int count)
+{
+  if(count > 0)
+    glDrawArrays(mode, first, count);
+}
+
+void meshArray_t::drawElements(GLenum mode, int first, int count)
+{
+  if(count <= 0)
+    return;
+
+  if(buffered)
+    glDrawElements(mode, count, GL_UNSIGNED_INT, 
+		   (const GLvoid*)(first * sizeof(GLuint)));
+  else
+    glDrawElements(mode, count, GL_UNSIGNED_INT, index.constData() + first);
+}
+
 // Construct glWidget...
 //-----------------------------------------------------------------------------
 GLWidget::GLWidget(QWidget *parent)
@@ -209,6 +411,13 @@ GLWidget::GLWidget(QWidget *parent)
   bgTexture = 0;
   bgSizeX = 0;
   bgSizeY = 0;
+
+  // Decimated surfaces while rotating:
+  surfaceArrayFlatShade = stateFlatShade;
+  lodActive = false;
+  lodTimer = new QTimer(this);
+  lodTimer->setSingleShot(true);
+  connect(lodTimer, SIGNAL(timeout()), this, SLOT(lodTimeout()));
 }
 
 
@@ -346,7 +555,7 @@ void GLWidget::paintGL()
 	  glPushMatrix();
 	  glTranslated(0, 0, 0.01);
 	  glTranslated(0, 0, ZSHIFT);
-	  glCallList(l->getObject()); 
+	  drawList(l);
 	  glPopMatrix();
 	  glMatrixMode(GL_MODELVIEW);
 	  
@@ -356,7 +565,7 @@ void GLWidget::paintGL()
 	  glPushMatrix();
 	  glTranslated(0, 0, 0.01);
 	  glTranslated(0, 0, ZSHIFT);
-	  glCallList(l->getObject()); 
+	  drawList(l);
 	  glPopMatrix();
 	  glMatrixMode(GL_MODELVIEW);
 	  
@@ -366,7 +575,7 @@ void GLWidget::paintGL()
 	  glPushMatrix();
 	  glTranslated(0, 0, 0.01);
 	  glTranslated(0, 0, ZSHIFT);
-	  glCallList(l->getObject()); 
+	  drawList(l);
 	  glPopMatrix();
 	  glMatrixMode(GL_MODELVIEW);
 
@@ -376,7 +585,7 @@ void GLWidget::paintGL()
 	  glPushMatrix();
 	  glTranslated(0, 0, 0.02);
 	  glTranslated(0, 0, ZSHIFT);
-	  glCallList(l->getObject()); 
+	  drawList(l);
 	  glPopMatrix();
 	  glMatrixMode(GL_MODELVIEW);
 
@@ -384,7 +593,7 @@ void GLWidget::paintGL()
 	  glMatrixMode(GL_PROJECTION);
 	  glPushMatrix();
 	  glTranslated(0, 0, ZSHIFT);
-	  glCallList(l->getObject());
+	  drawList(l);
 	  glPopMatrix();
 	  glMatrixMode(GL_MODELVIEW);
 
@@ -392,7 +601,7 @@ void GLWidget::paintGL()
 	  glMatrixMode(GL_PROJECTION);
 	  glPushMatrix();
 	  glTranslated(0, 0, ZSHIFT);
-	  glCallList(l->getObject()); 
+	  drawList(l);
 	  glPopMatrix();
 	  glMatrixMode(GL_MODELVIEW);
 	}
@@ -686,6 +895,7 @@ void GLWidget::wheelEvent(QWheelEvent *event)
 {
   double s = exp((double)(event->delta())*0.001);
   glScaled(s, s, s);
+  startLod();
   updateGL();
   lastPos = event->pos();
   getMatrix();
@@ -704,6 +914,9 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event)
   int dy = event->y() - lastPos.y();
 
   dy = -dy;
+
+  if(event->buttons() & (Qt::LeftButton | Qt::MidButton))
+    startLod();
   
   if (((event->buttons() & Qt::LeftButton) && 
        (event->buttons() & Qt::MidButton)) ) {
@@ -746,6 +959,45 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event)
 
 
 
+// Mouse button released...
+//-----------------------------------------------------------------------------
+void GLWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+  Q_UNUSED(event)
+
+  if(lodActive) {
+    lodTimer->stop();
+    lodTimeout();
+  }
+}
+
+
+
+// Draw the decimated surfaces until the view has been still for a while...
+//-----------------------------------------------------------------------------
+void GLWidget::startLod()
+{
+  for(int i = 0; i < getLists(); i++) {
+    if(getList(i)->getLodCount() > 0) {
+      lodActive = true;
+      lodTimer->start(LOD_TIMEOUT);
+      return;
+    }
+  }
+}
+
+
+
+// Back to full detail...
+//-----------------------------------------------------------------------------
+void GLWidget::lodTimeout()
+{
+  lodActive = false;
+  updateGL();
+}
+
+
+
 // Mouse button double clicked...
 //-----------------------------------------------------------------------------
 void GLWidget::mouseDoubleClickEvent(QMouseEvent *event)
@@ -843,7 +1095,6 @@ void GLWidget::mouseDoubleClickEvent(QMouseEvent *event)
       for(i = 0; i < getLists(); i++) {
 	list_t *l2 = getList(i);
 	if(l2->isSelected() && (l2->getIndex() != l->getIndex())) {
-	  glDeleteLists(l2->getObject(), 1);
 	  l2->setSelected(false);
 	  if(l2->getType() == SURFACELIST) {
             for( int j = 0; j < mesh->getSurfaces(); j++ ) {
@@ -851,14 +1102,14 @@ void GLWidget::mouseDoubleClickEvent(QMouseEvent *event)
               if ( surf->getIndex() == l2->getIndex() )
                 surf->setSelected(l2->isSelected());
             }
-	    l2->setObject(generateSurfaceList(l2->getIndex(), surfaceColor)); // cyan
+	    l2->setColor(surfaceColor); // cyan
 	  } else if(l2->getType() == EDGELIST) {
             for( int j=0; j < mesh->getEdges(); j++ ) {
               edge_t *edge = mesh->getEdge(j);
               if ( edge->getIndex() == l2->getIndex() )
                 edge->setSelected(l2->isSelected());
             }
-	    l2->setObject(generateEdgeList(l2->getIndex(), edgeColor)); // green
+	    l2->setColor(edgeColor); // green
 	  }
 	}
       }
@@ -866,15 +1117,13 @@ void GLWidget::mouseDoubleClickEvent(QMouseEvent *event)
 
     // Toggle selection:
     l->setSelected(!l->isSelected());
-    
-    glDeleteLists(l->getObject(), 1);
 
     // Highlight current selection:
     if(l->getType() == SURFACELIST) {
       if(l->isSelected()) {
-	l->setObject(generateSurfaceList(l->getIndex(), Qt::red)); // red
+	l->setColor(Qt::red); // red
       } else {
-	l->setObject(generateSurfaceList(l->getIndex(), surfaceColor)); // cyan
+	l->setColor(surfaceColor); // cyan
       }
 
       for( int i=0; i<mesh->getSurfaces(); i++ ) {
@@ -884,9 +1133,9 @@ void GLWidget::mouseDoubleClickEvent(QMouseEvent *event)
 
     } else if(l->getType() == EDGELIST) {
       if(l->isSelected()) {
-	l->setObject(generateEdgeList(l->getIndex(), Qt::red)); // red
+	l->setColor(Qt::red); // red
       } else {
-	l->setObject(generateEdgeList(l->getIndex(), edgeColor)); // green
+	l->setColor(edgeColor); // green
       }
       for( int i=0; i < mesh->getEdges(); i++ ) {
         edge_t *edge = mesh->getEdge(i);
@@ -1036,13 +1285,6 @@ void GLWidget::rebuildLists()
 
   delete [] bb;
  
-  if(getLists() > 0) {
-    for(int i=0; i < getLists(); i++) {
-      list_t *l = getList(i);
-      glDeleteLists(l->getObject(), 1);
-    }
-  }
-
   makeLists();
 
   updateGL();
@@ -1057,14 +1299,17 @@ void GLWidget::rebuildSurfaceLists()
     list_t *l = getList(i);
      if( l->getType() == SURFACELIST )
      {
-       glDeleteLists( l->getObject(), 1 );
        if(l->isSelected()) {
- 	 l->setObject(generateSurfaceList(l->getIndex(), Qt::red)); // red
+ 	 l->setColor(Qt::red); // red
        } else {
- 	 l->setObject(generateSurfaceList(l->getIndex(), surfaceColor)); // cyan
+ 	 l->setColor(surfaceColor); // cyan
        }
      }
   }
+
+  // Only the shading model changes the vertex data:
+  if((mesh != NULL) && (stateFlatShade != surfaceArrayFlatShade))
+    generateSurfaceArrays();
 }
 
 // Compose GL edge lists...
@@ -1076,11 +1321,10 @@ void GLWidget::rebuildEdgeLists()
     list_t *l = getList(i);
      if ( l->getType() == EDGELIST )
      {
-       glDeleteLists( l->getObject(), 1 );
        if(l->isSelected()) {
- 	 l->setObject(generateEdgeList(l->getIndex(), Qt::red)); // red
+ 	 l->setColor(Qt::red); // red
        } else {
- 	 l->setObject(generateEdgeList(l->getIndex(), edgeColor)); // green
+ 	 l->setColor(edgeColor); // green
        }
      }
   }
@@ -1109,6 +1353,9 @@ GLuint GLWidget::makeLists()
   // - All point elements with index >= 0 will be drawn - one list/index
   //   (list->type = POINTLIST)
   // - A list of sharp edges will always be drawn (even if it is empty)
+  //
+  // The lists draw ranges of the shared surface and line arrays that are
+  // generated once all lists are known.
   //---------------------------------------------------------------------------
   
   // Simultaneously, populate hash for mapping body & boundary incides:
@@ -1249,7 +1496,7 @@ GLuint GLWidget::makeLists()
       l->setNature(nature);
       l->setType(SURFACELIST);
       l->setIndex(index);
-      l->setObject(generateSurfaceList(l->getIndex(), surfaceColor)); // cyan
+      l->setColor(surfaceColor); // cyan
       l->setChild(getLists());
       l->setParent(-1);
       l->setSelected(false);
@@ -1262,7 +1509,7 @@ GLuint GLWidget::makeLists()
       l->setNature(PDE_UNKNOWN);
       l->setType(SURFACEMESHLIST);
       l->setIndex(index);
-      l->setObject(generateSurfaceMeshList(l->getIndex(), surfaceMeshColor)); // black
+      l->setColor(surfaceMeshColor); // black
       l->setChild(-1);
       l->setParent(getLists() - 2);
       l->setSelected(false);
@@ -1286,7 +1533,7 @@ GLuint GLWidget::makeLists()
       l->setNature(nature); 
       l->setType(EDGELIST);
       l->setIndex(index);
-      l->setObject(generateEdgeList(l->getIndex(), edgeColor)); // green
+      l->setColor(edgeColor); // green
       l->setChild(-1);
       l->setParent(-1);
       l->setSelected(false);
@@ -1304,7 +1551,7 @@ GLuint GLWidget::makeLists()
   l->setNature(PDE_UNKNOWN);
   l->setType(SHARPEDGELIST);
   l->setIndex(-1);
-  l->setObject(generateSharpEdgeList(sharpEdgeColor)); // black
+  l->setColor(sharpEdgeColor); // black
   l->setChild(-1);
   l->setParent(-1);
   l->setSelected(false);
@@ -1318,12 +1565,17 @@ GLuint GLWidget::makeLists()
   l->setNature(PDE_UNKNOWN);
   l->setType(VOLUMEMESHLIST);
   l->setIndex(-1);
-  l->setObject(generateVolumeMeshList(Qt::black)); // black
+  l->setColor(Qt::black); // black
   l->setChild(-1);
   l->setParent(-1);
   l->setSelected(false);
   l->setVisible(stateDrawVolumeMesh);
 
+  // Vertex data:
+  //--------------
+  generateSurfaceArrays();
+  generateLineArrays();
+
   // Clean up:
   //-----------
   edgeNatures.clear();
@@ -1340,436 +1592,446 @@ GLuint GLWidget::makeLists()
 }
 
 
-// Generate volume mesh list...
+// Draw a list from the shared arrays...
 //-----------------------------------------------------------------------------
-GLuint GLWidget::generateVolumeMeshList(QColor qColor)
+void GLWidget::drawList(list_t *l)
 {
-  static int tetmap[6][2] = {{0, 1}, {0, 2}, {0, 3}, 
-			     {1, 2}, {1, 3}, {2, 3}};
+  QColor c = l->getColor();
+  int type = l->getType();
+
+  if(type == SURFACELIST) {
+    meshArray_t *a = &surfaceArray;
+    int first = l->getFirst();
+    int count = l->getCount();
+
+    if(lodActive) {
+      a = &surfaceLodArray;
+      first = l->getLodFirst();
+      count = l->getLodCount();
+    }
 
-  static int wedgemap[9][2] = {{0, 1}, {1, 2}, {2, 0},
-			       {0, 3}, {1, 4}, {2, 5},
-			       {3, 4}, {4, 5}, {5, 3}};
+    bool useIndexColors = stateBodyColors || 
+      (stateBcColors && (l->getNature() == PDE_BOUNDARY));
 
+    glColor3d(c.redF(), c.greenF(), c.blueF());
+    a->bind();
+    a->enableColors(useIndexColors);
+    a->drawArrays(GL_TRIANGLES, first, count);
+    a->release();
 
-  static int hexmap[12][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0},
-			      {0, 4}, {1, 5}, {2, 6}, {3, 7},
-			      {4, 5}, {5, 6}, {6, 7}, {7, 4}};
+  } else if((type == SURFACEMESHLIST) || (type == VOLUMEMESHLIST) ||
+	    (type == EDGELIST) || (type == SHARPEDGELIST)) {
 
-  double R = qColor.red() / 255.0;
-  double G = qColor.green() / 255.0;
-  double B = qColor.blue() / 255.0;
+    // the mesh lines would cost more than the decimated surfaces:
+    if(lodActive && ((type == SURFACEMESHLIST) || (type == VOLUMEMESHLIST)))
+      return;
 
-  GLuint current = glGenLists(1);
-  glNewList(current, GL_COMPILE);
+    glLineWidth((type == EDGELIST) ? 4.0 : 1.0);
+    glDisable(GL_LIGHTING);
+    glColor3d(c.redF(), c.greenF(), c.blueF());
+    lineArray.bind();
+    lineArray.drawElements(GL_LINES, l->getFirst(), l->getCount());
+    lineArray.release();
+    glEnable(GL_LIGHTING);
+  }
+}
 
-  glBegin(GL_LINES);
 
-  for(int i = 0; i < mesh->getElements(); i++) {
-    element_t *element = mesh->getElement(i);
 
-    glColor3d(R, G, B);
+// Generate the triangles of the surface lists...
+//-----------------------------------------------------------------------------
+void GLWidget::generateSurfaceArrays()
+{
+  int surfaces = mesh->getSurfaces();
+  int lists = getLists();
 
-    int nofEdges = 0;
-    int *edgeMap = 0;
+  makeCurrent();
+  surfaceArray.clear();
+  surfaceLodArray.clear();
+  surfaceArrayFlatShade = stateFlatShade;
 
-    switch((int)(element->getCode() / 100)) {
-    case 5:
-      nofEdges = 6;
-      edgeMap = &tetmap[0][0];
-      break;
-    case 7:
-      nofEdges = 9;
-      edgeMap = &wedgemap[0][0];
-      break;
-    case 8:
-      nofEdges = 12;
-      edgeMap = &hexmap[0][0];
-      break;
-    }
-    
-    // draw edges:
-    for(int j = 0; j < nofEdges; j++) {
-      int p0 = *edgeMap++;
-      int p1 = *edgeMap++;
-      
-      int q0 = element->getNodeIndex(p0);
-      int q1 = element->getNodeIndex(p1);
-      
-      node_t *n0 = mesh->getNode(q0);
-      node_t *n1 = mesh->getNode(q1);
-      
-      double x0 = ( n0->getX(0) - drawTranslate[0] ) / drawScale;
-      double y0 = ( n0->getX(1) - drawTranslate[1] ) / drawScale;
-      double z0 = ( n0->getX(2) - drawTranslate[2] ) / drawScale;
-      
-      double x1 = ( n1->getX(0) - drawTranslate[0] ) / drawScale;
-      double y1 = ( n1->getX(1) - drawTranslate[1] ) / drawScale;
-      double z1 = ( n1->getX(2) - drawTranslate[2] ) / drawScale;
-      
-      glVertex3d(x0, y0, z0);
-      glVertex3d(x1, y1, z1);
+  QHash<int, int> surfaceList;
+  for(int i = 0; i < lists; i++) {
+    list_t *l = getList(i);
+    if(l->getType() == SURFACELIST) {
+      l->setRange(0, 0);
+      l->setLodRange(0, 0);
+      surfaceList.insert(l->getIndex(), i);
     }
   }
 
-  glEnd();
+  // Group the triangles by list, quads are split in two:
+  //------------------------------------------------------
+  QVector<int> listOf(surfaces, -1);
+  QVector<int> offset(lists + 1, 0);
 
-  glEndList();
+  for(int i = 0; i < surfaces; i++) {
+    surface_t *surface = mesh->getSurface(i);
+    int nodes = surface->getCode() / 100;
 
-  return current;
-}
+    if((nodes < 3) || (nodes > 4) || !surfaceList.contains(surface->getIndex()))
+      continue;
 
+    listOf[i] = surfaceList.value(surface->getIndex());
+    offset[listOf[i] + 1] += nodes - 2;
+  }
 
+  for(int i = 0; i < lists; i++)
+    offset[i + 1] += offset[i];
 
-// Generate surface list...
-//-----------------------------------------------------------------------------
-GLuint GLWidget::generateSurfaceList(int index, QColor qColor)
-{
-  double x0[3], x1[3], x2[3], x3[3], u[3];
+  QVector<int> triangle(surfaces, -1);
+  QVector<int> next(offset);
 
-  double R = qColor.red() / 255.0;
-  double G = qColor.green() / 255.0;
-  double B = qColor.blue() / 255.0;
+  for(int i = 0; i < surfaces; i++) {
+    if(listOf[i] < 0)
+      continue;
+    triangle[i] = next[listOf[i]];
+    next[listOf[i]] += mesh->getSurface(i)->getCode() / 100 - 2;
+  }
 
-  GLuint current = glGenLists(1);
-  glNewList(current, GL_COMPILE);
+  for(int i = 0; i < lists; i++) {
+    list_t *l = getList(i);
+    if(l->getType() == SURFACELIST)
+      l->setRange(3 * offset[i], 3 * (offset[i + 1] - offset[i]));
+  }
 
-  // Draw triangles:
-  //-----------------
-  glBegin(GL_TRIANGLES);
+  int triangles = offset[lists];
+  bool useIndexColors = stateBcColors || stateBodyColors;
 
-  for(int i=0; i < mesh->getSurfaces(); i++) {
-    surface_t *surface = mesh->getSurface(i);
+  surfaceArray.vertex.resize(9 * triangles);
+  surfaceArray.normal.resize(9 * triangles);
+  if(useIndexColors)
+    surfaceArray.color.resize(9 * triangles);
 
-    if((surface->getIndex() == index) && ((int)(surface->getCode() / 100) == 3)) {
+  GLfloat *vertex = surfaceArray.vertex.data();
+  GLfloat *normal = surfaceArray.normal.data();
+  GLfloat *color = useIndexColors ? surfaceArray.color.data() : NULL;
 
-      glColor3d(R, G, B);
+  // Fill in the vertices:
+  //-----------------------
+#pragma omp parallel for schedule(static)
+  for(int i = 0; i < surfaces; i++) {
+    if(triangle[i] < 0)
+      continue;
 
-      if(stateBcColors && (surface->getNature() == PDE_BOUNDARY)) {
-        double c[3];
-        indexColors(c, index);
-        glColor3d(c[0], c[1], c[2]);
-      } 
-	
-      if(stateBodyColors) {
-	int bodyIndex = surface->getIndex();
-	if(surface->getNature() == PDE_BOUNDARY) {
-	  int parentIndex = surface->getElementIndex(0);
-	  element_t *parent = mesh->getElement(parentIndex);
-	  bodyIndex = parent->getIndex();
-	}
-        double c[3];
-        indexColors(c, bodyIndex);
-        glColor3d(c[0], c[1], c[2]);
-      } 
-      
-      // change normal direction:
-      changeNormalDirection(u, surface->getNormalVec());
-      glNormal3dv(u); 
-      
-      int n0 = surface->getNodeIndex(0);
-      int n1 = surface->getNodeIndex(1);
-      int n2 = surface->getNodeIndex(2);
-      
-      x0[0] = (mesh->getNode(n0)->getX(0) - drawTranslate[0]) / drawScale;
-      x0[1] = (mesh->getNode(n0)->getX(1) - drawTranslate[1]) / drawScale;
-      x0[2] = (mesh->getNode(n0)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x1[0] = (mesh->getNode(n1)->getX(0) - drawTranslate[0]) / drawScale;
-      x1[1] = (mesh->getNode(n1)->getX(1) - drawTranslate[1]) / drawScale;
-      x1[2] = (mesh->getNode(n1)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x2[0] = (mesh->getNode(n2)->getX(0) - drawTranslate[0]) / drawScale;
-      x2[1] = (mesh->getNode(n2)->getX(1) - drawTranslate[1]) / drawScale;
-      x2[2] = (mesh->getNode(n2)->getX(2) - drawTranslate[2]) / drawScale;
+    static const int split[2][3] = {{0, 1, 2}, {0, 2, 3}};
+    surface_t *surface = mesh->getSurface(i);
+    int nodes = surface->getCode() / 100;
+    double u[3], c[3];
 
-      changeNormalDirection(u, surface->getVertexNormalVec(0));
-      if ( !stateFlatShade ) glNormal3dv(u);
-      glVertex3dv(x0);
+    c[0] = c[1] = c[2] = 1.0;
 
-      changeNormalDirection(u, surface->getVertexNormalVec(1));
-      if ( !stateFlatShade ) glNormal3dv(u);
-      glVertex3dv(x1);
+    if(stateBcColors && (surface->getNature() == PDE_BOUNDARY))
+      indexColors(c, surface->getIndex());
 
-      changeNormalDirection(u, surface->getVertexNormalVec(2));
-      if ( !stateFlatShade ) glNormal3dv(u);
-      glVertex3dv(x2);
+    if(stateBodyColors) {
+      int bodyIndex = surface->getIndex();
+      if(surface->getNature() == PDE_BOUNDARY) {
+	int parentIndex = surface->getElementIndex(0);
+	if(parentIndex >= 0)
+	  bodyIndex = mesh->getElement(parentIndex)->getIndex();
+      }
+      indexColors(c, bodyIndex);
     }
-  }
 
-  glEnd();
+    for(int t = 0; t < nodes - 2; t++) {
+      int k = 9 * (triangle[i] + t);
 
-  // Draw quads:
-  //------------
-  glBegin(GL_QUADS);
-  
-  for(int i=0; i < mesh->getSurfaces(); i++) {
-    surface_t *surface = mesh->getSurface(i);
+      for(int j = 0; j < 3; j++, k += 3) {
+	int corner = split[t][j];
+	node_t *node = mesh->getNode(surface->getNodeIndex(corner));
 
-    if((surface->getIndex() == index) && ((int)(surface->getCode() / 100) == 4)) {
+	vertex[k + 0] = (node->getX(0) - drawTranslate[0]) / drawScale;
+	vertex[k + 1] = (node->getX(1) - drawTranslate[1]) / drawScale;
+	vertex[k + 2] = (node->getX(2) - drawTranslate[2]) / drawScale;
 
-      glColor3d(R, G, B);
+	if(stateFlatShade)
+	  changeNormalDirection(u, surface->getNormalVec());
+	else
+	  changeNormalDirection(u, surface->getVertexNormalVec(corner));
 
-      if(stateBcColors && (surface->getNature() == PDE_BOUNDARY)) {
-        double c[3];
-        indexColors(c, index);
-        glColor3d(c[0], c[1], c[2]);
-      }
+	normal[k + 0] = u[0];
+	normal[k + 1] = u[1];
+	normal[k + 2] = u[2];
 
-      if(stateBodyColors) {
-	int bodyIndex = surface->getIndex();
-	if(surface->getNature() == PDE_BOUNDARY) {
-	  int parentIndex = surface->getElementIndex(0);
-	  element_t *parent = mesh->getElement(parentIndex);
-	  bodyIndex = parent->getIndex();
+	if(color) {
+	  color[k + 0] = c[0];
+	  color[k + 1] = c[1];
+	  color[k + 2] = c[2];
 	}
-        double c[3];
-        indexColors(c, bodyIndex);
-        glColor3d(c[0], c[1], c[2]);
-      } 
-
-      // change normal direction:
-      changeNormalDirection(u, surface->getNormalVec());
-      glNormal3dv(u); 
-      
-      int n0 = surface->getNodeIndex(0);
-      int n1 = surface->getNodeIndex(1);
-      int n2 = surface->getNodeIndex(2);
-      int n3 = surface->getNodeIndex(3);
-      
-      x0[0] = (mesh->getNode(n0)->getX(0) - drawTranslate[0]) / drawScale;
-      x0[1] = (mesh->getNode(n0)->getX(1) - drawTranslate[1]) / drawScale;
-      x0[2] = (mesh->getNode(n0)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x1[0] = (mesh->getNode(n1)->getX(0) - drawTranslate[0]) / drawScale;
-      x1[1] = (mesh->getNode(n1)->getX(1) - drawTranslate[1]) / drawScale;
-      x1[2] = (mesh->getNode(n1)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x2[0] = (mesh->getNode(n2)->getX(0) - drawTranslate[0]) / drawScale;
-      x2[1] = (mesh->getNode(n2)->getX(1) - drawTranslate[1]) / drawScale;
-      x2[2] = (mesh->getNode(n2)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x3[0] = (mesh->getNode(n3)->getX(0) - drawTranslate[0]) / drawScale;
-      x3[1] = (mesh->getNode(n3)->getX(1) - drawTranslate[1]) / drawScale;
-      x3[2] = (mesh->getNode(n3)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      changeNormalDirection(u, surface->getVertexNormalVec(0));
-      if ( !stateFlatShade ) glNormal3dv(u); 
-      glVertex3dv(x0);
-
-      changeNormalDirection(u, surface->getVertexNormalVec(1));
-      if ( !stateFlatShade ) glNormal3dv(u);
-      glVertex3dv(x1);
-
-      changeNormalDirection(u, surface->getVertexNormalVec(2));
-      if ( !stateFlatShade ) glNormal3dv(u);
-      glVertex3dv(x2);
-
-      changeNormalDirection(u, surface->getVertexNormalVec(3));
-      if ( !stateFlatShade ) glNormal3dv(u);
-      glVertex3dv(x3);      
+      }
     }
   }
 
-  glEnd();
-  glEndList();
+  if(triangles > LOD_LIMIT)
+    generateLodArrays();
 
-  return current;
+  surfaceArray.upload();
+  surfaceLodArray.upload();
 }
 
 
 
-// Generate surface edge list...
+// Decimate the surface triangles by clustering their vertices on a grid...
 //-----------------------------------------------------------------------------
-GLuint GLWidget::generateSurfaceMeshList(int index, QColor qColor)
+void GLWidget::generateLodArrays()
 {
-  double x0[3], x1[3], x2[3], x3[3];
+  const GLfloat *vertex = surfaceArray.vertex.constData();
+  const GLfloat *normal = surfaceArray.normal.constData();
+  const GLfloat *color = surfaceArray.color.isEmpty() ? NULL : surfaceArray.color.constData();
+  int vertices = surfaceArray.vertex.size() / 3;
+
+  double xmin[3], xmax[3];
+  for(int d = 0; d < 3; d++) {
+    xmin[d] = vertices ? vertex[d] : 0.0;
+    xmax[d] = xmin[d];
+  }
 
-  double R = qColor.red() / 255.0;
-  double G = qColor.green() / 255.0;
-  double B = qColor.blue() / 255.0;
+  for(int i = 0; i < vertices; i++) {
+    for(int d = 0; d < 3; d++) {
+      xmin[d] = qMin(xmin[d], (double)vertex[3 * i + d]);
+      xmax[d] = qMax(xmax[d], (double)vertex[3 * i + d]);
+    }
+  }
 
-  GLuint current = glGenLists(1);
-  glNewList(current, GL_COMPILE);
- 
-  // Draw lines:
-  //------------
-  glLineWidth(1.0);
-  glDisable(GL_LIGHTING);
-  glColor3d(R, G, B);
-  glBegin(GL_LINES);
-  
-  for(int i=0; i < mesh->getSurfaces(); i++) {
-    surface_t *surface = mesh->getSurface(i);
-    
-    if((surface->getIndex() == index) && ((int)(surface->getCode() / 100) == 3)) {
-      int n0 = surface->getNodeIndex(0);
-      int n1 = surface->getNodeIndex(1);
-      int n2 = surface->getNodeIndex(2);
-      
-      x0[0] = (mesh->getNode(n0)->getX(0) - drawTranslate[0]) / drawScale;
-      x0[1] = (mesh->getNode(n0)->getX(1) - drawTranslate[1]) / drawScale;
-      x0[2] = (mesh->getNode(n0)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x1[0] = (mesh->getNode(n1)->getX(0) - drawTranslate[0]) / drawScale;
-      x1[1] = (mesh->getNode(n1)->getX(1) - drawTranslate[1]) / drawScale;
-      x1[2] = (mesh->getNode(n1)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x2[0] = (mesh->getNode(n2)->getX(0) - drawTranslate[0]) / drawScale;
-      x2[1] = (mesh->getNode(n2)->getX(1) - drawTranslate[1]) / drawScale;
-      x2[2] = (mesh->getNode(n2)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      glVertex3dv(x0);
-      glVertex3dv(x1);
+  double h = qMax(xmax[0] - xmin[0], qMax(xmax[1] - xmin[1], xmax[2] - xmin[2]));
+  if(h <= 0.0)
+    return;
+
+  std::vector<qint64> key(vertices);
 
-      glVertex3dv(x1);
-      glVertex3dv(x2);
+  // Occupied cells of a coarse grid tell the resolution, for surfaces the
+  // number of clusters grows as the square of it:
+  //----------------------------------------------------------------------
+  qint64 n = 64;
 
-      glVertex3dv(x2);
-      glVertex3dv(x0);
+  for(int pass = 0; pass < 2; pass++) {
+#pragma omp parallel for schedule(static)
+    for(int i = 0; i < vertices; i++) {
+      qint64 c[3];
+      for(int d = 0; d < 3; d++)
+	c[d] = qMin(n - 1, (qint64)(n * (vertex[3 * i + d] - xmin[d]) / h));
+      key[i] = (c[0] * n + c[1]) * n + c[2];
     }
+
+    if(pass > 0)
+      break;
+
+    std::vector<qint64> cells(key);
+    std::sort(cells.begin(), cells.end());
+    double occupied = std::unique(cells.begin(), cells.end()) - cells.begin();
+
+    n = (qint64)(n * sqrt(LOD_TRIANGLES / (2.0 * occupied)));
+    n = qMax((qint64)8, qMin((qint64)1024, n));
   }
-  
-  for(int i=0; i < mesh->getSurfaces(); i++) {
-    surface_t *surface = mesh->getSurface(i);
 
-    if((surface->getIndex() == index) && ((int)(surface->getCode() / 100) == 4)) {
-      int n0 = surface->getNodeIndex(0);
-      int n1 = surface->getNodeIndex(1);
-      int n2 = surface->getNodeIndex(2);
-      int n3 = surface->getNodeIndex(3);
-      
-      x0[0] = (mesh->getNode(n0)->getX(0) - drawTranslate[0]) / drawScale;
-      x0[1] = (mesh->getNode(n0)->getX(1) - drawTranslate[1]) / drawScale;
-      x0[2] = (mesh->getNode(n0)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x1[0] = (mesh->getNode(n1)->getX(0) - drawTranslate[0]) / drawScale;
-      x1[1] = (mesh->getNode(n1)->getX(1) - drawTranslate[1]) / drawScale;
-      x1[2] = (mesh->getNode(n1)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x2[0] = (mesh->getNode(n2)->getX(0) - drawTranslate[0]) / drawScale;
-      x2[1] = (mesh->getNode(n2)->getX(1) - drawTranslate[1]) / drawScale;
-      x2[2] = (mesh->getNode(n2)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      x3[0] = (mesh->getNode(n3)->getX(0) - drawTranslate[0]) / drawScale;
-      x3[1] = (mesh->getNode(n3)->getX(1) - drawTranslate[1]) / drawScale;
-      x3[2] = (mesh->getNode(n3)->getX(2) - drawTranslate[2]) / drawScale;
-      
-      glVertex3dv(x0);
-      glVertex3dv(x1);
+  // Cluster the vertices and place them at their mean:
+  //----------------------------------------------------
+  std::vector<qint64> cells(key);
+  std::sort(cells.begin(), cells.end());
+  cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
 
-      glVertex3dv(x1);
-      glVertex3dv(x2);
+  int clusters = cells.size();
+  std::vector<int> cluster(vertices);
 
-      glVertex3dv(x2);
-      glVertex3dv(x3);
+#pragma omp parallel for schedule(static)
+  for(int i = 0; i < vertices; i++)
+    cluster[i] = std::lower_bound(cells.begin(), cells.end(), key[i]) - cells.begin();
 
-      glVertex3dv(x3);
-      glVertex3dv(x0);      
-    }
+  std::vector<double> x(3 * clusters, 0.0);
+  std::vector<int> members(clusters, 0);
+
+  for(int i = 0; i < vertices; i++) {
+    int c = cluster[i];
+    for(int d = 0; d < 3; d++)
+      x[3 * c + d] += vertex[3 * i + d];
+    members[c]++;
   }
-  glEnd();
 
-  glEnable(GL_LIGHTING);
-  glEndList();
-  
-  return current;
-}
+  for(int c = 0; c < clusters; c++)
+    for(int d = 0; d < 3; d++)
+      x[3 * c + d] /= members[c];
 
+  // Keep the triangles that do not collapse, once per list:
+  //---------------------------------------------------------
+  for(int i = 0; i < getLists(); i++) {
+    list_t *l = getList(i);
 
-// Generate edge list...
-//-----------------------------------------------------------------------------
-GLuint GLWidget::generateEdgeList(int index, QColor qColor)
-{
-  double x0[3], x1[3];
+    if((l->getType() != SURFACELIST) || (l->getCount() == 0))
+      continue;
 
-  double R = qColor.red() / 255.0;
-  double G = qColor.green() / 255.0;
-  double B = qColor.blue() / 255.0;
+    // (sorted clusters, triangle) to find the duplicates
+    std::vector<std::pair<std::pair<qint64, int>, int> > kept;
 
-  GLuint current = glGenLists(1);
-  glNewList(current, GL_COMPILE);
-  glColor3d(R, G, B);  
-  glLineWidth(4.0);
-  glDisable(GL_LIGHTING);
-  glBegin(GL_LINES);
+    for(int t = l->getFirst() / 3; t < (l->getFirst() + l->getCount()) / 3; t++) {
+      qint64 c[3];
+      for(int j = 0; j < 3; j++)
+	c[j] = cluster[3 * t + j];
 
-  for(int i=0; i < mesh->getEdges(); i++) {
-    edge_t *edge = mesh->getEdge(i);
+      if((c[0] == c[1]) || (c[1] == c[2]) || (c[2] == c[0]))
+	continue;
 
-    if(edge->getIndex() == index) {
-      int n0 = edge->getNodeIndex(0);
-      int n1 = edge->getNodeIndex(1);
-	
-      x0[0] = (mesh->getNode(n0)->getX(0) - drawTranslate[0]) / drawScale;
-      x0[1] = (mesh->getNode(n0)->getX(1) - drawTranslate[1]) / drawScale;
-      x0[2] = (mesh->getNode(n0)->getX(2) - drawTranslate[2]) / drawScale;
-	
-      x1[0] = (mesh->getNode(n1)->getX(0) - drawTranslate[0]) / drawScale;
-      x1[1] = (mesh->getNode(n1)->getX(1) - drawTranslate[1]) / drawScale;
-      x1[2] = (mesh->getNode(n1)->getX(2) - drawTranslate[2]) / drawScale;
-	
-      glVertex3dv(x0);
-      glVertex3dv(x1);
+      std::sort(c, c + 3);
+      kept.push_back(std::make_pair(std::make_pair(c[0] * clusters + c[1], (int)c[2]), t));
+    }
+
+    std::sort(kept.begin(), kept.end());
+
+    int first = surfaceLodArray.vertex.size() / 3;
+
+    for(int k = 0; k < (int)kept.size(); k++) {
+      if((k > 0) && (kept[k].first == kept[k - 1].first))
+	continue;
+
+      int t = kept[k].second;
+      double p[3][3], u[3], v[3], w[3], m[3];
+
+      for(int j = 0; j < 3; j++)
+	for(int d = 0; d < 3; d++)
+	  p[j][d] = x[3 * cluster[3 * t + j] + d];
+
+      for(int d = 0; d < 3; d++) {
+	u[d] = p[1][d] - p[0][d];
+	v[d] = p[2][d] - p[0][d];
+	m[d] = normal[9 * t + d] + normal[9 * t + 3 + d] + normal[9 * t + 6 + d];
+      }
+
+      w[0] = u[1] * v[2] - u[2] * v[1];
+      w[1] = u[2] * v[0] - u[0] * v[2];
+      w[2] = u[0] * v[1] - u[1] * v[0];
+
+      // keep the orientation of the original normal
+      double sign = (w[0] * m[0] + w[1] * m[1] + w[2] * m[2] < 0.0) ? -1.0 : 1.0;
+
+      for(int j = 0; j < 3; j++) {
+	for(int d = 0; d < 3; d++) {
+	  surfaceLodArray.vertex.push_back(p[j][d]);
+	  surfaceLodArray.normal.push_back(sign * w[d]);
+	  if(color)
+	    surfaceLodArray.color.push_back(color[9 * t + d]);
+	}
+      }
     }
+
+    l->setLodRange(first, surfaceLodArray.vertex.size() / 3 - first);
   }
-  
-  glEnd();
 
-  glEnable(GL_LIGHTING);  
-  glEndList();
-  
-  return current;
+  cout << "Decimated " << vertices / 3 << " surface triangles to " 
+       << surfaceLodArray.vertex.size() / 9 << " for rotation" << endl;
+  cout.flush();
 }
 
 
 
-// Generate sharp edge list...
+// Generate the line segments of the mesh, edge and sharp edge lists...
 //-----------------------------------------------------------------------------
-GLuint GLWidget::generateSharpEdgeList(QColor qColor)
+void GLWidget::generateLineArrays()
 {
-  double x0[3], x1[3];
+  static int tetmap[6][2] = {{0, 1}, {0, 2}, {0, 3}, 
+			     {1, 2}, {1, 3}, {2, 3}};
 
-  double R = qColor.red() / 255.0;
-  double G = qColor.green() / 255.0;
-  double B = qColor.blue() / 255.0;
+  static int wedgemap[9][2] = {{0, 1}, {1, 2}, {2, 0},
+			       {0, 3}, {1, 4}, {2, 5},
+			       {3, 4}, {4, 5}, {5, 3}};
 
-  GLuint current = glGenLists(1);
-  glNewList(current, GL_COMPILE);
+  static int hexmap[12][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0},
+			      {0, 4}, {1, 5}, {2, 6}, {3, 7},
+			      {4, 5}, {5, 6}, {6, 7}, {7, 4}};
 
-  glColor3d(R, G, B);  
-  glLineWidth(1.0);
-  glDisable(GL_LIGHTING);
-  glBegin(GL_LINES);
-  
-  for(int i=0; i < mesh->getEdges(); i++) {
-    edge_t *edge = mesh->getEdge(i);
+  int nodes = mesh->getNodes();
 
-    if(edge->isSharp()) {
-      int n0 = edge->getNodeIndex(0);
-      int n1 = edge->getNodeIndex(1);
-	
-      x0[0] = (mesh->getNode(n0)->getX(0) - drawTranslate[0]) / drawScale;
-      x0[1] = (mesh->getNode(n0)->getX(1) - drawTranslate[1]) / drawScale;
-      x0[2] = (mesh->getNode(n0)->getX(2) - drawTranslate[2]) / drawScale;
-	
-      x1[0] = (mesh->getNode(n1)->getX(0) - drawTranslate[0]) / drawScale;
-      x1[1] = (mesh->getNode(n1)->getX(1) - drawTranslate[1]) / drawScale;
-      x1[2] = (mesh->getNode(n1)->getX(2) - drawTranslate[2]) / drawScale;
-	
-      glVertex3dv(x0);
-      glVertex3dv(x1);
+  makeCurrent();
+  lineArray.clear();
+
+  // The nodes are shared by all lines:
+  //------------------------------------
+  lineArray.vertex.resize(3 * nodes);
+  GLfloat *vertex = lineArray.vertex.data();
+
+#pragma omp parallel for schedule(static)
+  for(int i = 0; i < nodes; i++) {
+    node_t *node = mesh->getNode(i);
+    vertex[3 * i + 0] = (node->getX(0) - drawTranslate[0]) / drawScale;
+    vertex[3 * i + 1] = (node->getX(1) - drawTranslate[1]) / drawScale;
+    vertex[3 * i + 2] = (node->getX(2) - drawTranslate[2]) / drawScale;
+  }
+
+  QVector<GLuint> &index = lineArray.index;
+
+  for(int i = 0; i < getLists(); i++) {
+    list_t *l = getList(i);
+    int first = index.size();
+
+    if(l->getType() == SURFACEMESHLIST) {
+      for(int j = 0; j < mesh->getSurfaces(); j++) {
+	surface_t *surface = mesh->getSurface(j);
+	int n = surface->getCode() / 100;
+
+	if((surface->getIndex() != l->getIndex()) || (n < 3) || (n > 4))
+	  continue;
+
+	for(int k = 0; k < n; k++) {
+	  index.push_back(surface->getNodeIndex(k));
+	  index.push_back(surface->getNodeIndex((k + 1) % n));
+	}
+      }
+
+    } else if(l->getType() == EDGELIST) {
+      for(int j = 0; j < mesh->getEdges(); j++) {
+	edge_t *edge = mesh->getEdge(j);
+	if(edge->getIndex() == l->getIndex()) {
+	  index.push_back(edge->getNodeIndex(0));
+	  index.push_back(edge->getNodeIndex(1));
+	}
+      }
+
+    } else if(l->getType() == SHARPEDGELIST) {
+      for(int j = 0; j < mesh->getEdges(); j++) {
+	edge_t *edge = mesh->getEdge(j);
+	if(edge->isSharp()) {
+	  index.push_back(edge->getNodeIndex(0));
+	  index.push_back(edge->getNodeIndex(1));
+	}
+      }
+
+    } else if(l->getType() == VOLUMEMESHLIST) {
+      for(int j = 0; j < mesh->getElements(); j++) {
+	element_t *element = mesh->getElement(j);
+	int nofEdges = 0;
+	int *edgeMap = 0;
+
+	switch((int)(element->getCode() / 100)) {
+	case 5:
+	  nofEdges = 6;
+	  edgeMap = &tetmap[0][0];
+	  break;
+	case 7:
+	  nofEdges = 9;
+	  edgeMap = &wedgemap[0][0];
+	  break;
+	case 8:
+	  nofEdges = 12;
+	  edgeMap = &hexmap[0][0];
+	  break;
+	}
+
+	for(int k = 0; k < nofEdges; k++) {
+	  index.push_back(element->getNodeIndex(*edgeMap++));
+	  index.push_back(element->getNodeIndex(*edgeMap++));
+	}
+      }
+    } else {
+      continue;
     }
+
+    l->setRange(first, index.size() - first);
   }
-  
-  glEnd();
-  glEnable(GL_LIGHTING);  
-  glEndList();
-  
-  return current;
+
+  lineArray.upload();
 }
 
 
+
 // Draw coordinates:
 //-----------------------------------------------------------------------------
 void GLWidget::drawCoordinates()
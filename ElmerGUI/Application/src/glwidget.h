@@ -64,6 +64,8 @@ enum ListTypes {
 #endif
 
 #include <QGLWidget>
+#include <QGLBuffer>
+#include <QTimer>
 #include <QHash>
 #include <QVector>
 #include "helpers.h"
@@ -82,8 +84,14 @@ class list_t {
   int getType() const;
   void setIndex(int);
   int getIndex() const;
-  void setObject(GLuint);
-  GLuint getObject() const;
+  void setRange(int, int);
+  int getFirst() const;
+  int getCount() const;
+  void setLodRange(int, int);
+  int getLodFirst() const;
+  int getLodCount() const;
+  void setColor(QColor);
+  QColor getColor() const;
   void setChild(int);
   int getChild() const;
   void setParent(int);
@@ -97,13 +105,47 @@ class list_t {
   int nature;        // PDE_UNKNOWN, PDE_BOUNDARY, PDE_BULK, ...
   int type;          // POINTLIST, EDGELIST, SURFACELIST, ...
   int index;         // Boundary condition as defined in input file
-  GLuint object;     // GL list index as returned by glGenLists()
+  int first;         // First vertex or index in the mesh array
+  int count;         // Number of vertices or indices in the mesh array
+  int lodFirst;      // First vertex in the decimated surface array
+  int lodCount;      // Number of vertices in the decimated surface array
+  QColor color;      // Color unless drawn with index colors
   int child;         // Index to the child list (-1 = no child)
   int parent;        // Index to the parent list (-1 = no parent)
   bool selected;     // Currently selected?
   bool visible;      // Currently visible?
 };
 
+// Vertex data shared by the lists. The lists draw ranges of it, either 
+// from vertex buffer objects or from client side arrays.
+class meshArray_t {
+ public:
+  meshArray_t();
+  ~meshArray_t();
+
+  void clear();
+  void upload();
+  void bind();
+  void release();
+  void enableColors(bool);
+  void drawArrays(GLenum, int, int);
+  void drawElements(GLenum, int, int);
+
+  QVector<GLfloat> vertex;  // x, y, z
+  QVector<GLfloat> normal;  // nx, ny, nz (optional)
+  QVector<GLfloat> color;   // r, g, b (optional)
+  QVector<GLuint> index;    // element indices (optional)
+
+ private:
+  QGLBuffer vertexBuffer;
+  QGLBuffer normalBuffer;
+  QGLBuffer colorBuffer;
+  QGLBuffer indexBuffer;
+  bool buffered;            // Data is in the buffer objects
+  bool normals;
+  bool colors;
+};
+
 class GLWidget : public QGLWidget
 {
   Q_OBJECT
@@ -171,6 +213,9 @@ public:
 
 public slots:
 
+private slots:
+  void lodTimeout();
+
 signals:
   void signalBoundarySelected(list_t*);
   void escPressed();
@@ -184,6 +229,7 @@ protected:
   void mouseDoubleClickEvent(QMouseEvent*);
   void mousePressEvent(QMouseEvent*);
   void mouseMoveEvent(QMouseEvent*);
+  void mouseReleaseEvent(QMouseEvent*);
   void wheelEvent(QWheelEvent*);
   void keyPressEvent(QKeyEvent*);
   void keyReleaseEvent(QKeyEvent*);
@@ -204,11 +250,18 @@ private:
   
   QPoint lastPos;
   
-  GLuint generateSurfaceList(int, QColor);
-  GLuint generateSurfaceMeshList(int, QColor);
-  GLuint generateVolumeMeshList(QColor);
-  GLuint generateEdgeList(int, QColor);
-  GLuint generateSharpEdgeList(QColor);
+  meshArray_t surfaceArray;     // Triangles of the surface elements
+  meshArray_t surfaceLodArray;  // Decimated triangles for interaction
+  meshArray_t lineArray;        // Nodes and line segments
+  bool surfaceArrayFlatShade;
+  bool lodActive;
+  QTimer *lodTimer;
+
+  void generateSurfaceArrays();
+  void generateLodArrays();
+  void generateLineArrays();
+  void drawList(list_t*);
+  void startLod();
   
   GLUquadricObj *quadric_axis;
   void drawCoordinates();
@@ -46,6 +46,7 @@
 #include <QSystemTrayIcon>
 #include <QContextMenuEvent>
 #include <QTimeLine>
+#include <QEventLoop>
 #include <QFileInfo>
 #include <QStringList>
 #include <QDir>
@@ -1453,8 +1454,7 @@ void MainWindow::loadElmerMesh(QString dirName)
     return;
   }
 
-  meshutils->findSurfaceElementEdges(glWidget->getMesh());
-  meshutils->findSurfaceElementNormals(glWidget->getMesh());
+  findBoundaryElements(glWidget->getMesh(), false);
   
   glWidget->rebuildLists();
 
@@ -1465,6 +1465,31 @@ void MainWindow::loadElmerMesh(QString dirName)
 }
 
 
+// Find the boundary elements of a mesh in a separate thread. The GUI is 
+// kept repainted meanwhile but user input is held until the thread is done.
+//-----------------------------------------------------------------------------
+void MainWindow::findBoundaryElements(mesh_t *mesh, bool findSurfaces)
+{
+  MeshutilsThread thread(meshutils, mesh, findSurfaces);
+  QEventLoop loop;
+
+  connect(&thread, SIGNAL(finished()), &loop, SLOT(quit()));
+
+  progressBar->show();
+  progressBar->setRange(0, 0);
+  progressLabel->show();
+  progressLabel->setText("Boundaries");
+
+  thread.start();
+  loop.exec(QEventLoop::ExcludeUserInputEvents);
+  thread.wait();
+
+  progressBar->hide();
+  progressBar->setRange(0, 100);
+  progressLabel->hide();
+}
+
+
 // File -> Save...
 //-----------------------------------------------------------------------------
 void MainWindow::saveSlot()
@@ -4842,19 +4867,7 @@ void MainWindow::remeshSlot()
     elmergridAPI->createElmerMeshStructure(mesh, meshControl->elmerGridControlString.toAscii());
 #endif
     
-    if(mesh->getSurfaces() == 0) meshutils->findSurfaceElements(mesh);
-    
-    for(int i = 0; i < mesh->getSurfaces(); i++ ) {
-      surface_t *surface = mesh->getSurface(i);
-      
-      surface->setEdges((int)(surface->getCode() / 100));
-      surface->newEdgeIndexes(surface->getEdges());
-      for(int j=0; j<surface->getEdges(); j++)
-	surface->setEdgeIndex(j, -1);
-    }
-
-    meshutils->findSurfaceElementEdges(mesh);
-    meshutils->findSurfaceElementNormals(mesh);
+    findBoundaryElements(mesh, true);
 
     glWidget->rebuildLists();
     applyOperations();
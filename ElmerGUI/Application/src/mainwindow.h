@@ -431,6 +431,7 @@ private:
   // utility functions:
   void readInputFile(QString);
   void loadElmerMesh(QString);
+  void findBoundaryElements(mesh_t*, bool);
   void saveElmerMesh(QString);
   void makeElmerMeshFromTetlib();
   void makeElmerMeshFromNglib();
@@ -42,6 +42,8 @@
 #include <iostream>
 #include <stdlib.h>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include "meshutils.h"
 using namespace std;
 
@@ -82,6 +84,44 @@ Meshutils::~Meshutils()
 }
 
 
+MeshutilsThread::MeshutilsThread(Meshutils *meshutils, mesh_t *mesh,
+				 bool findSurfaces, QObject *parent)
+  : QThread(parent)
+{
+  this->meshutils = meshutils;
+  this->mesh = mesh;
+  this->findSurfaces = findSurfaces;
+}
+
+
+MeshutilsThread::~MeshutilsThread()
+{
+}
+
+
+// With findSurfaces the surface elements are found from the volume elements 
+// if they are not given, and the edges of the surfaces are reset.
+//-----------------------------------------------------------------------------
+void MeshutilsThread::run()
+{
+  if(findSurfaces) {
+    if(mesh->getSurfaces() == 0) meshutils->findSurfaceElements(mesh);
+    
+    for(int i = 0; i < mesh->getSurfaces(); i++ ) {
+      surface_t *surface = mesh->getSurface(i);
+      
+      surface->setEdges((int)(surface->getCode() / 100));
+      surface->newEdgeIndexes(surface->getEdges());
+      for(int j=0; j<surface->getEdges(); j++)
+	surface->setEdgeIndex(j, -1);
+    }
+  }
+
+  meshutils->findSurfaceElementEdges(mesh);
+  meshutils->findSurfaceElementNormals(mesh);
+}
+
+
 // Clear mesh...
 //-----------------------------------------------------------------------------
 void Meshutils::clearMesh(mesh_t *mesh)
@@ -98,172 +138,223 @@ void Meshutils::clearMesh(mesh_t *mesh)
 
 
 
-// Find surface elements for 3D elements when they are not provided 
+// Face maps of 3D elements: tetrahedra (5), pyramids (6), wedges (7) and
+// hexahedra (8). Only 1st and 2nd order elements.
 //----------------------------------------------------------------------------
-void Meshutils::findSurfaceElements(mesh_t *mesh)
-{
-#define RESETENTRY1             \
-  h->node[0] = UNKNOWN;		\
-  h->node[1] = UNKNOWN;  	\
-  h->element[0] = UNKNOWN;	\
-  h->element[1] = UNKNOWN;	\
-  h->index[0] = UNKNOWN;        \
-  h->index[1] = UNKNOWN;        \
-  h->next = NULL;               
+static int familyfaces[9] = {0, 0, 0, 0, 0, 4, 5, 5, 6};
 
-  class hashEntry {
-  public:
-    int node[2];
-    int element[2];
-    int index[2];
-    int face;
-    hashEntry *next;
-  };
+static int faceedges8[] = {4, 4, 4, 4, 4, 4};
+static int facemap8[][8] = {{0,1,2,3,8,9,10,11}, {4,5,6,7,16,17,18,19}, {0,1,5,4,8,13,16,12}, {1,2,6,5,9,14,17,13}, {2,3,7,6,10,15,18,14}, {3,0,4,7,11,12,19,15}};
 
+static int faceedges7[] = {3, 3, 4, 4, 4};
+static int facemap7[][8] = {{0,1,2,6,7,8}, {3,4,5,12,13,14}, {0,1,4,3,6,10,12,9}, {1,2,5,4,7,11,13,10}, {2,0,3,5,8,9,14,11}};
 
-  if(mesh->getElements() == 0) return;
+static int faceedges6[] = {4, 3, 3, 3, 3};
+static int facemap6[][8] = {{0,1,2,3,5,6,7,8}, {0,1,4,5,10,9}, {1,2,4,6,11,10}, {2,3,4,7,12,11}, {3,0,4,8,9,12}};
 
-  int keys = mesh->getNodes();  
-  hashEntry *hash = new hashEntry[keys];
+static int faceedges5[4] = {3, 3, 3, 3};
+static int facemap5[][6] = {{0,1,2,4,5,6}, {0,1,3,4,8,7}, {1,2,3,5,9,8}, {2,0,3,6,7,9}};
 
-  bool found;
-  hashEntry *h;
+static int *faceMap(int family, int f, int &faceedges)
+{
+  faceedges = 0;
+  if(family == 5) {
+    faceedges = faceedges5[f];
+    return &facemap5[f][0];
+  }
+  else if(family == 6) {
+    faceedges = faceedges6[f];
+    return &facemap6[f][0];
+  }
+  else if(family == 7) {
+    faceedges = faceedges7[f];
+    return &facemap7[f][0];
+  }
+  else if(family == 8) {
+    faceedges = faceedges8[f];
+    return &facemap8[f][0];
+  }
+  return NULL;
+}
 
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-    RESETENTRY1;
+// The three smallest nodes of a face in an increasing order. They define
+// the face uniquely also for rectangles.
+static void faceKeyNodes(element_t *e, int f, int *n)
+{
+  int faceedges;
+  int *facemap = faceMap(e->getCode() / 100, f, faceedges);
+  int m[4];
+
+  for(int j=0; j < faceedges; j++)
+    m[j] = e->getNodeIndex(facemap[j]);
+
+  for(int k=1; k < faceedges; k++) {
+    int tmp = m[k], j = k;
+    for(; j > 0 && m[j-1] > tmp; j--)
+      m[j] = m[j-1];
+    m[j] = tmp;
   }
 
-  // TODO: only 1st and 2nd order elements
+  n[0] = m[0];
+  n[1] = m[1];
+  n[2] = m[2];
+}
 
-  static int familyfaces[9] = {0, 0, 0, 0, 0, 4, 5, 5, 6};
+// Face or edge key bucketed by its smallest node. The entries of the bucket 
+// of node i are entry[bucket[i]] ... entry[bucket[i+1]-1]. The id tells 
+// where the key came from and gives the order in which they were met.
+class nodeKey {
+public:
+  int node[2];
+  int id;
+
+  bool operator<(const nodeKey &k) const {
+    if(node[0] != k.node[0]) return node[0] < k.node[0];
+    if(node[1] != k.node[1]) return node[1] < k.node[1];
+    return id < k.id;
+  }
+};
 
-  static int faceedges8[] = {4, 4, 4, 4, 4, 4};
-  static int facemap8[][8] = {{0,1,2,3,8,9,10,11}, {4,5,6,7,16,17,18,19}, {0,1,5,4,8,13,16,12}, {1,2,6,5,9,14,17,13}, {2,3,7,6,10,15,18,14}, {3,0,4,7,11,12,19,15}};
+static bool nodeKeyIdLess(const nodeKey &a, const nodeKey &b)
+{
+  return a.id < b.id;
+}
 
-  static int faceedges7[] = {3, 3, 4, 4, 4};
-  static int facemap7[][8] = {{0,1,2,6,7,8}, {3,4,5,12,13,14}, {0,1,4,3,6,10,12,9}, {1,2,5,4,7,11,13,10}, {2,0,3,5,8,9,14,11}};
+static bool nodeKeyRunLess(const nodeKey &a, const nodeKey &b)
+{
+  if(a.node[1] != b.node[1]) return a.node[1] < b.node[1];
+  return a.id < b.id;
+}
 
-  static int faceedges6[] = {4, 3, 3, 3, 3};
-  static int facemap6[][8] = {{0,1,2,3,5,6,7,8}, {0,1,4,5,10,9}, {1,2,4,6,11,10}, {2,3,4,7,12,11}, {3,0,4,8,9,12}};
+// Turn the bucket sizes, stored in bucket[i+1], into bucket offsets
+static void bucketOffsets(vector<int> &bucket)
+{
+  for(int i=1; i < (int)bucket.size(); i++) 
+    bucket[i] += bucket[i-1];
+}
 
-  static int faceedges5[4] = {3, 3, 3, 3};
-  static int facemap5[][6] = {{0,1,2,4,5,6}, {0,1,3,4,8,7}, {1,2,3,5,9,8}, {2,0,3,6,7,9}};
 
 
-  for(int i=0; i < mesh->getElements(); i++) {
-    element_t *e = mesh->getElement(i);
+// Find surface elements for 3D elements when they are not provided 
+//----------------------------------------------------------------------------
+void Meshutils::findSurfaceElements(mesh_t *mesh)
+{
+  if(mesh->getElements() == 0) return;
 
-    int facenodes = 0;
-    int *facemap = NULL;
-    int n[4];
+  int keys = mesh->getNodes();
+  int elements = mesh->getElements();
 
-    int family = e->getCode() / 100;
-    int faces = familyfaces[family];
+  // Bucket the faces by their smallest node, the key of a face is then 
+  // the two next nodes and the id is 8 * element + face.
+  vector<int> bucket(keys + 1, 0);
+
+#pragma omp parallel for schedule(static)
+  for(int i=0; i < elements; i++) {
+    element_t *e = mesh->getElement(i);
+    int faces = familyfaces[e->getCode() / 100];
+    int n[3];
 
     for(int f=0; f<faces; f++) {
-      if(family == 5) {
-	facenodes = faceedges5[f];
-	facemap = &facemap5[f][0];
-      }
-      else if(family == 6) {
-	facenodes = faceedges6[f];
-	facemap = &facemap6[f][0];
-      }
-      else if(family == 7) {
-	facenodes = faceedges7[f];
-	facemap = &facemap7[f][0];
-      }
-      else if(family == 8) {
-	facenodes = faceedges8[f];
-	facemap = &facemap8[f][0];
-      }
+      faceKeyNodes(e, f, n);
+#pragma omp atomic
+      bucket[n[0] + 1]++;
+    }
+  }
+  bucketOffsets(bucket);
 
-      for(int j=0; j < facenodes; j++) 
-	n[j] = e->getNodeIndex(facemap[j]);
+  vector<nodeKey> key(bucket[keys]);
+  vector<int> pos(bucket.begin(), bucket.end() - 1);
 
-      // Order indexes in an increasing order 
-      for(int k=facenodes-1;k>0;k--) {
-	for(int j=0;j<k;j++) {
-	  if(n[j] > n[j+1]) {
-	    int tmp = n[j+1];
-	    n[j+1] = n[j];
-	    n[j] = tmp;
-	  } 
-	}
-      }
-      
-      // three nodes define a face uniquely also for rectangles
-      h = &hash[n[0]];
-      found = false;
-      while(h->next) {                                       
-	if((h->node[0] == n[1]) && (h->node[1] == n[2])) {
-	  found = true;
-	  break;
-	}
-	h = h->next;
-      }                                                      
-      
-      if(!found) {
-	h->node[0] = n[1];
-	h->node[1] = n[2];
-	h->element[0] = i;
-	h->index[0] = e->getIndex();
-	h->face = f;
-	
-	h->next = new hashEntry;
-	h = h->next;
-	RESETENTRY1;
-      } else {
-	h->index[1] = e->getIndex();
-	h->element[1] = i;
-      }
+#pragma omp parallel for schedule(static)
+  for(int i=0; i < elements; i++) {
+    element_t *e = mesh->getElement(i);
+    int faces = familyfaces[e->getCode() / 100];
+    int n[3], k;
+
+    for(int f=0; f<faces; f++) {
+      faceKeyNodes(e, f, n);
+#pragma omp atomic capture
+      k = pos[n[0]]++;
+      key[k].node[0] = n[1];
+      key[k].node[1] = n[2];
+      key[k].id = 8 * i + f;
     }
   }
+  vector<int>().swap(pos);
 
-  // count faces that have different materials at either sides:
+  // Sort the buckets and find the unique faces. The faces that have different 
+  // materials at either sides are packed to the start of the bucket as
+  // (id of the 1st element, id of the 2nd element or UNKNOWN) in the order 
+  // they were met.
+  vector<int> found(keys + 1, 0);
   int allsurfaces = 0;
-  int surfaces = 0;
-  int maxindex1 = 0;
-  int maxindex2 = 0;
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-    while(h->next){
-      if(h->element[0] > UNKNOWN) allsurfaces++;
-      if(h->index[0] != h->index[1]) surfaces++;
-      if(h->index[0] > maxindex1) maxindex1 = h->index[0];
-      if(h->index[1] > maxindex2) maxindex2 = h->index[1];
-      h = h->next;
+
+#pragma omp parallel for schedule(dynamic, 1024) reduction(+:allsurfaces)
+  for(int i=0; i < keys; i++) {
+    nodeKey *b = &key[bucket[i]];
+    int n = bucket[i+1] - bucket[i];
+    int surfaces = 0;
+
+    sort(b, b + n);
+
+    for(int j=0; j < n; ) {
+      int k = j + 1;
+      while((k < n) && (b[k].node[0] == b[j].node[0]) && (b[k].node[1] == b[j].node[1]))
+	k++;
+      allsurfaces++;
+
+      int id0 = b[j].id;
+      int id1 = (k - j > 1) ? b[k-1].id : UNKNOWN;
+      int index0 = mesh->getElement(id0 / 8)->getIndex();
+      int index1 = (id1 >= 0) ? mesh->getElement(id1 / 8)->getIndex() : UNKNOWN;
+
+      if(index0 != index1) {
+	b[surfaces].node[0] = id0;
+	b[surfaces].node[1] = id1;
+	b[surfaces].id = id0;
+	surfaces++;
+      }
+      j = k;
     }
+
+    sort(b, b + surfaces, nodeKeyIdLess);
+    found[i+1] = surfaces;
   }
-  cout << "Found " << surfaces << " interface faces of " << allsurfaces << endl;
+  bucketOffsets(found);
 
+  int surfaces = found[keys];
+  cout << "Found " << surfaces << " interface faces of " << allsurfaces << endl;
 
   // Create a index table such that all combinations of materials 
   // get different BC index  
-  //int indextable[maxindex1+1][maxindex2+1];
-  int **indextable = AllocateDynamicArray<int>(maxindex1+1, maxindex2+1);
-  int index1,index2;
-  for(int i=0;i<=maxindex1;i++)
-    for(int j=0;j<=maxindex2;j++)
-      indextable[i][j] = 0;
+  int maxindex1 = 0;
+  int maxindex2 = 0;
+  for(int i=0; i < keys; i++) {
+    for(int j=0; j < found[i+1] - found[i]; j++) {
+      nodeKey *b = &key[bucket[i] + j];
+      int index1 = mesh->getElement(b->node[0] / 8)->getIndex();
+      int index2 = (b->node[1] >= 0) ? mesh->getElement(b->node[1] / 8)->getIndex() : 0;
+      if(index1 > maxindex1) maxindex1 = index1;
+      if(index2 > maxindex2) maxindex2 = index2;
+    }
+  }
 
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-    while(h->next){
-      if(h->index[0] != h->index[1]) {
-	index1 = h->index[0];
-	index2 = h->index[1];
-	if(index2 == -1) index2 = 0;
-	indextable[index1][index2] = 1;
-      }
-      h = h->next;
+  int cols = maxindex2 + 1;
+  vector<int> indextable((maxindex1 + 1) * cols, 0);
+
+  for(int i=0; i < keys; i++) {
+    for(int j=0; j < found[i+1] - found[i]; j++) {
+      nodeKey *b = &key[bucket[i] + j];
+      int index1 = mesh->getElement(b->node[0] / 8)->getIndex();
+      int index2 = (b->node[1] >= 0) ? mesh->getElement(b->node[1] / 8)->getIndex() : 0;
+      if(index2 < 0) index2 = 0;
+      indextable[index1 * cols + index2] = 1;
     }
   }
-  index1=0;
-  for(int i=0;i<=maxindex1;i++)
-    for(int j=0;j<=maxindex2;j++)
-      if(indextable[i][j]) indextable[i][j] = ++index1;
+
+  int index1 = 0;
+  for(int i=0; i < (int)indextable.size(); i++)
+    if(indextable[i]) indextable[i] = ++index1;
 
   cout << "Boundaries were numbered up to index " << index1 << endl;
 
@@ -271,77 +362,50 @@ void Meshutils::findSurfaceElements(mesh_t *mesh)
   mesh->setSurfaces(surfaces);
   mesh->newSurfaceArray(mesh->getSurfaces());
 
-  surfaces = 0;
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-
-    while(h->next) {
-      if(h->index[0] != h->index[1]) {
-	surface_t *s = mesh->getSurface(surfaces);
-
-	s->setElements(1);
-	s->newElementIndexes(2); 
-	s->setElementIndex(0, h->element[0]);
-	s->setElementIndex(1, h->element[1]);
-	if(s->getElementIndex(1) >= 0) s->setElements(2); // ?????
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(int i=0; i < keys; i++) {
+    for(int j=0; j < found[i+1] - found[i]; j++) {
+      nodeKey *b = &key[bucket[i] + j];
+      surface_t *s = mesh->getSurface(found[i] + j);
+
+      s->setElements(1);
+      s->newElementIndexes(2); 
+      s->setElementIndex(0, b->node[0] / 8);
+      s->setElementIndex(1, (b->node[1] >= 0) ? b->node[1] / 8 : UNKNOWN);
+      if(s->getElementIndex(1) >= 0) s->setElements(2); // ?????
 	
-	element_t *e = mesh->getElement(h->element[0]);
-	int code = e->getCode();
-	int family = code / 100;
-	int f = h->face;
-
-	int faceedges = 0;
-	int *facemap = NULL;
-	int degree = 1;
-
-	if(family == 5) {
-	  faceedges = faceedges5[f];
-	  if( code == 510) degree = 2;
-	  facemap = &facemap5[f][0];
-	}
-	else if(family == 6) {
-	  faceedges = faceedges6[f];
-	  if( code == 613) degree = 2;
-	  facemap = &facemap6[f][0];
-	}
-	else if(family == 7) {
-	  faceedges = faceedges7[f];
-	  if( code == 715) degree = 2;
-	  facemap = &facemap7[f][0];
-	}
-	else if(family == 8) {
-	  faceedges = faceedges8[f];
-	  if( code == 820 ) degree = 2;
-	  facemap = &facemap8[f][0];
-	}
+      element_t *e = mesh->getElement(s->getElementIndex(0));
+      int code = e->getCode();
+      int f = b->node[0] % 8;
+      int faceedges = 0;
+      int *facemap = faceMap(code / 100, f, faceedges);
+      int degree = 1;
+
+      if((code == 510) || (code == 613) || (code == 715) || (code == 820))
+	degree = 2;
 	
-	int facenodes = degree * faceedges;
+      int facenodes = degree * faceedges;
 
-	s->setNodes(facenodes);
-	s->setCode(100 * faceedges + facenodes);
-	s->newNodeIndexes(s->getNodes());
-	for(int j=0; j < s->getNodes(); j++) 
-	  s->setNodeIndex(j, e->getNodeIndex(facemap[j]));
+      s->setNodes(facenodes);
+      s->setCode(100 * faceedges + facenodes);
+      s->newNodeIndexes(s->getNodes());
+      for(int k=0; k < s->getNodes(); k++) 
+	s->setNodeIndex(k, e->getNodeIndex(facemap[k]));
 
-	index1 = h->index[0];
-	index2 = h->index[1];
-	if(index2 < 0) index2 = 0;
+      int index1 = e->getIndex();
+      int index2 = (s->getElementIndex(1) >= 0) ? mesh->getElement(s->getElementIndex(1))->getIndex() : 0;
+      if(index2 < 0) index2 = 0;
 	
-	s->setIndex(indextable[index1][index2]);
+      s->setIndex(indextable[index1 * cols + index2]);
 
-	s->setEdges(s->getNodes());
-	s->newEdgeIndexes(s->getEdges());
-	for(int j=0; j < s->getEdges(); j++)
-	  s->setEdgeIndex(j, UNKNOWN);
+      s->setEdges(s->getNodes());
+      s->newEdgeIndexes(s->getEdges());
+      for(int k=0; k < s->getEdges(); k++)
+	s->setEdgeIndex(k, UNKNOWN);
 
-	s->setNature(PDE_BOUNDARY);
-	surfaces++;
-      }
-      h = h->next;
+      s->setNature(PDE_BOUNDARY);
     }
   }
-
-  delete [] hash;
 }
 
 
@@ -734,284 +798,267 @@ void Meshutils::findEdgeElementPoints(mesh_t *mesh)
 //-----------------------------------------------------------------------------
 void Meshutils::findSurfaceElementEdges(mesh_t *mesh)
 {
-#define RESETENTRY              \
-    h->surfaces = 0;            \
-    h->surface = NULL;          \
-    h->parentindex[0] = UNKNOWN; \
-    h->parentindex[1] = UNKNOWN; \
-    h->next = NULL;
+  static int triedgemap[][4] = { {0,1,3,6}, {1,2,4,7}, {2,0,5,8} };
+  static int quadedgemap[][4] = {{0,1,4,8}, {1,2,5,9}, {2,3,6,10}, {3,0,7,11}};
 
   int keys = mesh->getNodes();
+  int oldedges = mesh->getEdges();
+  int surfaces = mesh->getSurfaces();
 
-  class hashEntry {
-  public:
-    int nodes;
-    int *node;
-    int nature;
-    int index;
-    int surfaces;
-    int *surface;
-    int parentindex[2];
-    hashEntry *next;
-  };
-  
-  hashEntry *hash = new hashEntry[keys];
-
-  bool found;
-  hashEntry *h;
+  bool createindexes = ((!mesh->getEdges()) && (!mesh->getElements()));
 
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-    RESETENTRY;
+  for(int i=0; i < surfaces; i++) {
+    int family = mesh->getSurface(i)->getCode() / 100;
+    if((family != 3) && (family != 4)) {
+      cout << "findBoundaryElementEdges: error: unknown element code" << endl;
+      exit(0);
+    }
   }
 
-  bool createindexes = ((!mesh->getEdges()) && (!mesh->getElements()));
+  // Bucket the edges by their smallest node, the key of an edge is then the 
+  // other node. The existing edges come first with the id of the edge, and 
+  // then the edges of the surfaces with the id oldedges + 4 * surface + edge.
+  vector<int> bucket(keys + 1, 0);
 
-  // ????? should we test for mesh->edges ?????
-  // if ( mesh->edge && (mesh->getEdges() > 0) ) {  
-  if ( mesh->getEdges() > 0 ) {  
-    // add existing edges first:
-    for( int i=0; i<mesh->getEdges(); i++ )
-    {
+#pragma omp parallel
+  {
+#pragma omp for schedule(static)
+    for(int i=0; i < oldedges; i++) {
       edge_t *edge = mesh->getEdge(i);
       int n0 = edge->getNodeIndex(0);
       int n1 = edge->getNodeIndex(1);
+#pragma omp atomic
+      bucket[min(n0, n1) + 1]++;
+    }
 
-      int m = (n0<n1) ? n0 : n1;
-      int n = (n0<n1) ? n1 : n0;
-
-      h = &hash[m];
-      found = false;
-      while(h->next) {                                       
-        if(h->node[0] == n) {
-          found = true;
-          break;
-        }
-        h = h->next;
-      }                                                      
-      
-      if(!found) {
-        h->nodes = edge->getNodes() - 1;
-        h->node = new int[h->nodes];
-        h->node[0] = n;
-        for( int j=1; j<h->nodes; j++ )
-        {
-          h->node[j] = edge->getNodeIndex(j+1);
-        }
-        h->surfaces = edge->getSurfaces();
-        h->surface = new int[edge->getSurfaces()];
-        for( int j=0; j < edge->getSurfaces(); j++ ) {
-          h->surface[j] = edge->getSurfaceIndex(j);
-        }
-        h->index  = edge->getIndex();
-        h->nature = edge->getNature();
-        h->next = new hashEntry;
-        h = h->next;
-        RESETENTRY;
+#pragma omp for schedule(static)
+    for(int i=0; i < surfaces; i++) {
+      surface_t *s = mesh->getSurface(i);
+      int (*edgemap)[4] = (s->getCode() / 100 == 3) ? triedgemap : quadedgemap;
+      for(int e=0; e < s->getEdges(); e++) {
+	int n0 = s->getNodeIndex(edgemap[e][0]);
+	int n1 = s->getNodeIndex(edgemap[e][1]);
+#pragma omp atomic
+	bucket[min(n0, n1) + 1]++;
       }
     }
-
-    mesh->setEdges(0);
-    mesh->deleteEdgeArray(); // delete [] mesh->edge;
   }
+  bucketOffsets(bucket);
 
+  vector<nodeKey> key(bucket[keys]);
+  vector<int> pos(bucket.begin(), bucket.end() - 1);
 
-  static int triedgemap[][4] = { {0,1,3,6}, {1,2,4,7}, {2,0,5,8} };
-  static int quadedgemap[][4] = {{0,1,4,8}, {1,2,5,9}, {2,3,6,10}, {3,0,7,11}};
+#pragma omp parallel
+  {
+#pragma omp for schedule(static)
+    for(int i=0; i < oldedges; i++) {
+      edge_t *edge = mesh->getEdge(i);
+      int n0 = edge->getNodeIndex(0);
+      int n1 = edge->getNodeIndex(1);
+      int k;
+#pragma omp atomic capture
+      k = pos[min(n0, n1)]++;
+      key[k].node[0] = max(n0, n1);
+      key[k].node[1] = 0;
+      key[k].id = i;
+    }
 
-  
-  for(int i=0; i < mesh->getSurfaces(); i++) {
-    surface_t *s = mesh->getSurface(i);
-    
-    // loop over edges
-    for(int e=0; e < s->getEdges(); e++) {
-      int n0, n1,nrest[2] = { -1,-1 };
-      if((int)(s->getCode() / 100) == 3) {
-	n0 = s->getNodeIndex(triedgemap[e][0]);
-	n1 = s->getNodeIndex(triedgemap[e][1]);
-	if ( s->getCode() >= 306) nrest[0] = s->getNodeIndex(triedgemap[e][2]);
-	if ( s->getCode() >= 309) nrest[1] = s->getNodeIndex(triedgemap[e][3]);
-      } else if((int)(s->getCode() / 100) == 4) {
-	n0 = s->getNodeIndex(quadedgemap[e][0]);
-	n1 = s->getNodeIndex(quadedgemap[e][1]);
-	// corrected 4.11.2008:
-	if ( s->getCode() >= 408) nrest[0] = s->getNodeIndex(quadedgemap[e][2]);
-	if ( s->getCode() >= 412) nrest[1] = s->getNodeIndex(quadedgemap[e][3]);
-      } else {
-	cout << "findBoundaryElementEdges: error: unknown element code" << endl;
-	exit(0);
+#pragma omp for schedule(static)
+    for(int i=0; i < surfaces; i++) {
+      surface_t *s = mesh->getSurface(i);
+      int (*edgemap)[4] = (s->getCode() / 100 == 3) ? triedgemap : quadedgemap;
+      for(int e=0; e < s->getEdges(); e++) {
+	int n0 = s->getNodeIndex(edgemap[e][0]);
+	int n1 = s->getNodeIndex(edgemap[e][1]);
+	int k;
+#pragma omp atomic capture
+	k = pos[min(n0, n1)]++;
+	key[k].node[0] = max(n0, n1);
+	key[k].node[1] = 0;
+	key[k].id = oldedges + 4 * i + e;
       }
+    }
+  }
+  vector<int>().swap(pos);
 
-      int m = (n0<n1) ? n0 : n1;
-      int n = (n0<n1) ? n1 : n0;
+  // Sort the buckets and group the entries of an edge together in the order 
+  // the edges were first met, node[1] is the id of the first entry.
+  vector<int> found(keys + 1, 0);
 
-      h = &hash[m];
-      found = false;
-      while(h->next) {                                       
-	if(h->node[0] == n) {
-	  found = true;
-	  break;
-	}
-	h = h->next;
-      }                                                      
-      
-      if(!found) {
-        h->nodes = 1;
-        h->nodes += nrest[0] >=0 ? 1:0;
-        h->nodes += nrest[1] >=0 ? 1:0;
-        h->node = new int[h->nodes];
-        h->node[0] = n;
-        for( int j=1; j<h->nodes; j++ )
-          h->node[j] = nrest[j-1];
-
-	h->surfaces = 1;
-	h->surface = new int[1];
-	h->surface[0] = i;
-	h->parentindex[0] = s->getIndex();
-        h->index = UNKNOWN;
-        h->nature = PDE_UNKNOWN;
-	h->next = new hashEntry;
-	h = h->next;
-	RESETENTRY;
-      } else {
-        int *tmp  = new int[h->surfaces];
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(int i=0; i < keys; i++) {
+    nodeKey *b = &key[bucket[i]];
+    int n = bucket[i+1] - bucket[i];
+    int edges = 0;
 
-        found = false;
-        for(int j=0; j<h->surfaces; j++)
-        {
-          tmp[j] = h->surface[j];
-          if ( tmp[j] == i ) found = true; 
-        }
-        if ( found ) {
-          delete [] tmp;
-        } else {
-          delete [] h->surface;
-          h->surface = new int[h->surfaces+1];
-          for(int j=0; j<h->surfaces; j++)
-             h->surface[j] = tmp[j];
-          h->surface[h->surfaces++] = i;
-	  if( s->getIndex() < h->parentindex[0]) {	    
-	    h->parentindex[1] = h->parentindex[0];
-	    h->parentindex[0] = s->getIndex();
-	  }
-	  else {
-	    h->parentindex[1] = s->getIndex();
-	  }	    
-          delete [] tmp;
-        }
-      }
-    }
-  }
+    sort(b, b + n);
 
-  // count edges:
-  int edges = 0;
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-    while((h = h->next) != NULL) 
+    for(int j=0; j < n; ) {
+      int k = j;
+      for(; (k < n) && (b[k].node[0] == b[j].node[0]); k++)
+	b[k].node[1] = b[j].id;
       edges++;
-  }
+      j = k;
+    }
 
-    
+    sort(b, b + n, nodeKeyRunLess);
+    found[i+1] = edges;
+  }
+  bucketOffsets(found);
 
+  int edges = found[keys];
   cout << "Found " << edges << " edges on boundary" << endl;
 
+  edge_t *oldedge = (oldedges > 0) ? mesh->getEdge(0) : NULL;
+
   mesh->setEdges(edges);
   mesh->newEdgeArray(edges); // edge = new edge_t[edges];
 
+  // Create edges:
+  vector<int> parentindex(2 * edges, UNKNOWN);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+  for(int i=0; i < keys; i++) {
+    nodeKey *b = &key[bucket[i]];
+    int n = bucket[i+1] - bucket[i];
+    vector<int> surface;
+
+    for(int j=0, r=found[i]; j < n; r++) {
+      int k = j + 1;
+      while((k < n) && (b[k].node[1] == b[j].node[1]))
+	k++;
+
+      edge_t *e = mesh->getEdge(r);
+      int *parent = &parentindex[2 * r];
+      int index = UNKNOWN;
+      int nature = PDE_UNKNOWN;
+
+      surface.clear();
+      e->setNodes(2);
+
+      for(int l=j; l < k; l++) {
+	int id = b[l].id;
+
+	if(id < oldedges) {
+	  // existing edge, only the first one counts
+	  if(l > j) continue;
+	  edge_t *edge = &oldedge[id];
+
+	  e->setNodes(edge->getNodes());
+	  e->newNodeIndexes(e->getNodes());
+	  for(int m=2; m < e->getNodes(); m++)
+	    e->setNodeIndex(m, edge->getNodeIndex(m));
+	  for(int m=0; m < edge->getSurfaces(); m++)
+	    surface.push_back(edge->getSurfaceIndex(m));
+	  index = edge->getIndex();
+	  nature = edge->getNature();
+	  continue;
+	}
+
+	int si = (id - oldedges) / 4;
+	surface_t *s = mesh->getSurface(si);
+
+	if(l == j) {
+	  int *edgemap = (s->getCode() / 100 == 3) ? triedgemap[(id - oldedges) % 4] : quadedgemap[(id - oldedges) % 4];
+	  int nrest[2] = { -1, -1 };
+	  if(s->getCode() / 100 == 3) {
+	    if(s->getCode() >= 306) nrest[0] = s->getNodeIndex(edgemap[2]);
+	    if(s->getCode() >= 309) nrest[1] = s->getNodeIndex(edgemap[3]);
+	  } else {
+	    if(s->getCode() >= 408) nrest[0] = s->getNodeIndex(edgemap[2]);
+	    if(s->getCode() >= 412) nrest[1] = s->getNodeIndex(edgemap[3]);
+	  }
+	  e->setNodes(2 + (nrest[0] >= 0 ? 1 : 0) + (nrest[1] >= 0 ? 1 : 0));
+	  e->newNodeIndexes(e->getNodes());
+	  for(int m=2; m < e->getNodes(); m++)
+	    e->setNodeIndex(m, nrest[m-2]);
+	  surface.push_back(si);
+	  parent[0] = s->getIndex();
+	  continue;
+	}
+
+	if(find(surface.begin(), surface.end(), si) != surface.end())
+	  continue;
+
+	surface.push_back(si);
+	if(s->getIndex() < parent[0]) {	    
+	  parent[1] = parent[0];
+	  parent[0] = s->getIndex();
+	}
+	else {
+	  parent[1] = s->getIndex();
+	}	    
+      }
+
+      e->setNature(nature);
+      e->setNodeIndex(0, i);
+      e->setNodeIndex(1, b[j].node[0]);
+
+      e->setCode(200 + e->getNodes());
+
+      e->setSurfaces((int)surface.size());
+      e->newSurfaceIndexes(max(e->getSurfaces(), 2));
+      e->setSurfaceIndex(0, -1);
+      e->setSurfaceIndex(1, -1);
+
+      for(int m=0; m < e->getSurfaces(); m++)
+	e->setSurfaceIndex(m, surface[m]);
+
+      e->setSharp(false);
+
+      e->setIndex(index);
+      e->setPoints(0);
+
+      j = k;
+    }
+  }
+
+  delete [] oldedge;
+
   if(createindexes) {
     cout << "Creating edge indexes " << endl;
 
     int maxindex1 = UNKNOWN;
     int maxindex2 = UNKNOWN;
     
-    for(int i=0; i<keys; i++) {
-      h = &hash[i];
-      while(h->next){
-	if(h->parentindex[0] > maxindex1) maxindex1 = h->parentindex[0];
-	if(h->parentindex[1] > maxindex2) maxindex2 = h->parentindex[1];
-	h = h->next;
-      }
+    for(int i=0; i < edges; i++) {
+      if(parentindex[2*i] > maxindex1) maxindex1 = parentindex[2*i];
+      if(parentindex[2*i+1] > maxindex2) maxindex2 = parentindex[2*i+1];
     }
  
     // Create a index table such that all combinations of materials 
     // get different BC index  
-    //int indextable[maxindex1+2][maxindex2+2];
-    int **indextable = AllocateDynamicArray<int>(maxindex1+2, maxindex2+2);
+    int cols = maxindex2 + 2;
+    vector<int> indextable((maxindex1 + 2) * cols, 0);
     int index1,index2;
-    for(int i=-1;i<=maxindex1;i++)
-      for(int j=-1;j<=maxindex2;j++)
-	indextable[i+1][j+1] = 0;
 
     int edgebcs=0;
-    for(int i=0; i<keys; i++) {
-      h = &hash[i];
-      while(h->next){
-	if(h->parentindex[0] != h->parentindex[1]) {
-	  index1 = h->parentindex[0];
-	  index2 = h->parentindex[1];
-	  indextable[index1+1][index2+1] = 1;
-	  edgebcs += 1;
-	}
-	h = h->next;
+    for(int i=0; i < edges; i++) {
+      index1 = parentindex[2*i];
+      index2 = parentindex[2*i+1];
+      if(index1 != index2) {
+	indextable[(index1+1) * cols + index2+1] = 1;
+	edgebcs += 1;
       }
     }
 
     index1=0;
-    for(int i=-1;i<=maxindex1;i++)
-      for(int j=-1;j<=maxindex2;j++) 
-	if(indextable[i+1][j+1]) indextable[i+1][j+1] = ++index1;
+    for(int i=0; i < (int)indextable.size(); i++)
+      if(indextable[i]) indextable[i] = ++index1;
 
     cout << edgebcs << " boundary edges were numbered up to index " << index1 << endl;
     
-    for(int i=0; i<keys; i++) {
-      h = &hash[i];
-      while(h->next){
-	if(h->parentindex[0] != h->parentindex[1]) {
-	  index1 = h->parentindex[0];
-	  index2 = h->parentindex[1];
-	  h->index = indextable[index1+1][index2+1];
-	  h->nature = PDE_BOUNDARY;
-	}
-	h = h->next;
+    for(int i=0; i < edges; i++) {
+      index1 = parentindex[2*i];
+      index2 = parentindex[2*i+1];
+      if(index1 != index2) {
+	edge_t *e = mesh->getEdge(i);
+	e->setIndex(indextable[(index1+1) * cols + index2+1]);
+	e->setNature(PDE_BOUNDARY);
       }
     }
   }
 
-
-  // Create edges:
-  edges = 0;
-  for(int i=0; i<keys; i++) {
-    h = &hash[i];
-    while(h->next) {
-      edge_t *e = mesh->getEdge(edges++);
-      
-      e->setNature(h->nature);
-      e->setNodes(h->nodes + 1);
-      e->newNodeIndexes(e->getNodes());
-      e->setNodeIndex(0, i); // ?????
-      for( int j=1; j < e->getNodes(); j++ )
-        e->setNodeIndex(j, h->node[j-1]);
-
-      e->setCode(200 + e->getNodes());
-
-      e->setSurfaces(h->surfaces);
-      e->newSurfaceIndexes(max(e->getSurfaces(), 2));
-      e->setSurfaceIndex(0, -1);
-      e->setSurfaceIndex(1, -1);
-
-      for(int j=0; j < e->getSurfaces(); j++)
-	e->setSurfaceIndex(j, h->surface[j]);
-
-      e->setSharp(false);
-
-      e->setIndex(h->index);
-      e->setPoints(0);
-      h = h->next;
-    }
-  }
-
-  delete [] hash;
-
   // Inverse map
   for(int i=0; i < mesh->getEdges(); i++) {
     edge_t *e = mesh->getEdge(i);
@@ -42,6 +42,7 @@
 #define MESHUTILS_H
 
 #include <math.h>
+#include <QThread>
 #include "meshtype.h"
 #include "helpers.h"
 
@@ -71,4 +72,21 @@ class Meshutils
   void decreaseElementOrder(mesh_t*);
   int cleanHangingSharpEdges(mesh_t*);
 };
+
+// Finds the boundary elements, their edges and normals outside of the 
+// GUI thread:
+class MeshutilsThread : public QThread
+{
+ public:
+  MeshutilsThread(Meshutils*, mesh_t*, bool, QObject *parent = 0);
+  ~MeshutilsThread();
+
+ protected:
+  void run();
+
+ private:
+  Meshutils *meshutils;
+  mesh_t *mesh;
+  bool findSurfaces;
+};
 #endif // #ifndef MESHUTILS_H
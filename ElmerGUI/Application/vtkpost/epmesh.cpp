@@ -101,3 +101,17 @@ ScalarField::~ScalarField()
 {
   delete [] value;
 }
+
+// EpStep:
+//=========
+EpStep::EpStep()
+{
+  step = 0;
+  values = 0;
+  value = NULL;
+}
+
+EpStep::~EpStep()
+{
+  delete [] value;
+}
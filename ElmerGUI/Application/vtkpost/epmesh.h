@@ -98,4 +98,17 @@ class ScalarField
   double maxVal;
 };
 
+// EpStep:
+//=========
+class EpStep
+{
+ public:
+  EpStep();
+  ~EpStep();
+
+  int step;
+  int values;
+  double *value;   // node by node, components in the order of the file
+};
+
 #endif // EPMESH_H
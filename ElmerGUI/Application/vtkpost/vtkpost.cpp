@@ -41,6 +41,9 @@
 #include <QtGui>
 #include <QScriptEngine>
 #include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 
 #include "epmesh.h"
 #include "vtkpost.h"
@@ -309,6 +312,9 @@ VtkPost::VtkPost(QWidget *parent)
   postFileRead = false;
   scalarFields = 0;
   scalarField = new ScalarField[MAX_SCALARS];
+  lazyPostFile = false;
+  epStepCacheSize = 0;
+  currentStep = 0;
 
   // Central widget:
   //----------------
@@ -440,6 +446,7 @@ VtkPost::VtkPost(QWidget *parent)
 
 VtkPost::~VtkPost()
 {
+  clearStepCache();
 }
 
 void VtkPost::createActions()
@@ -1030,6 +1037,18 @@ bool VtkPost::ReadPostFile(QString postFileName)
   cout << "Scalar components: " << components << endl;
   cout << "Timesteps: " << timesteps << endl;
 
+  // Large files are read one time step at a time, when it is needed:
+  //------------------------------------------------------------------
+  clearStepCache();
+  stepFieldNames.clear();
+  stepOffset.clear();
+
+  double dataSize = (double)nodes * timesteps * components * sizeof(double);
+  lazyPostFile = (dataSize > EP_LAZY_LIMIT);
+  int fieldValues = lazyPostFile ? nodes : nodes * timesteps;
+
+  if(lazyPostFile)
+    cout << "Time steps are read on demand" << endl;
 
   // Read field names & set up menu actions:
   //=========================================
@@ -1051,7 +1070,7 @@ bool VtkPost::ReadPostFile(QString postFileName)
   // Add the null field:
   //--------------------
   QString fieldName = "Null";
-  ScalarField* nullField = addScalarField(fieldName, nodes*timesteps, NULL);
+  ScalarField* nullField = addScalarField(fieldName, fieldValues, NULL);
   nullField->minVal = 0.0;
   nullField->maxVal = 0.0;
 
@@ -1069,10 +1088,10 @@ bool VtkPost::ReadPostFile(QString postFileName)
     cout << fieldName.toAscii().data() << endl;
 
     if(fieldType == "scalar")
-      addScalarField(fieldName, nodes*timesteps, NULL);
+      addScalarField(fieldName, fieldValues, NULL);
 
     if(fieldType == "vector") {
-      addVectorField(fieldName, nodes*timesteps);
+      addVectorField(fieldName, fieldValues);
       i += 2;
     }
   }
@@ -1144,26 +1163,45 @@ bool VtkPost::ReadPostFile(QString postFileName)
   int start = readEpFile->ui.start->value() - 1;
   int end = readEpFile->ui.end->value() - 1;
 
-  // skip values before start:
-  for(int i = 0; i < nodes * start; i++) {
-    if(postStream.atEnd()) break;
-    getPostLineStream(&postStream);
-  }
+  int real_timesteps = 0;
 
-  ScalarField *sf;
-  int i;
-  for(i = 0; i < nodes * (end - start + 1); i++) {
-    if(postStream.atEnd()) break;
-    getPostLineStream(&postStream);
+  if(lazyPostFile) {
+    for(int j = 0; j < scalarFields-4; j++) // - 4 = no nodes, no null field
+      stepFieldNames << scalarField[j+1].name;  // + 1 = skip null field
+
+    if(!indexPostFile(postStream.pos(), nodes, start, end))
+      cout << "Unable to index the time steps of the ep-file" << endl;
+
+    real_timesteps = qMax(stepOffset.count() - 1, 0);
+    cout << real_timesteps << " timesteps found." << endl;
 
-    for(int j = 0; j < scalarFields-4; j++) { // - 4 = no nodes, no null field
-      sf = &scalarField[j+1];                 // + 1 = skip null field
-      postLineStream >> sf->value[i];
+    epStepCacheSize = (int)(EP_CACHE_LIMIT / qMax(dataSize / timesteps, 1.0));
+    epStepCacheSize = qMax(epStepCacheSize, 2);
+    loadTimeStep(1);
+
+  } else {
+
+    // skip values before start:
+    for(int i = 0; i < nodes * start; i++) {
+      if(postStream.atEnd()) break;
+      getPostLineStream(&postStream);
     }
-  }
 
-  int real_timesteps = i/nodes;
-  cout << real_timesteps << " timesteps read in." << endl;
+    ScalarField *sf;
+    int i;
+    for(i = 0; i < nodes * (end - start + 1); i++) {
+      if(postStream.atEnd()) break;
+      getPostLineStream(&postStream);
+
+      for(int j = 0; j < scalarFields-4; j++) { // - 4 = no nodes, no null field
+	sf = &scalarField[j+1];                 // + 1 = skip null field
+	postLineStream >> sf->value[i];
+      }
+    }
+
+    real_timesteps = i/nodes;
+    cout << real_timesteps << " timesteps read in." << endl;
+  }
 
   // Initial min & max values:
   //============================
@@ -1284,6 +1322,208 @@ bool VtkPost::ReadPostFile(QString postFileName)
   return true;
 }
 
+// Find where the time steps start in the post file:
+//----------------------------------------------------------------------
+bool VtkPost::indexPostFile(qint64 dataStart, int nodes, int start, int end)
+{
+  stepOffset.clear();
+
+  if(nodes < 1)
+    return false;
+
+  QFile postFile(postFileName);
+
+  if(!postFile.open(QIODevice::ReadOnly) || !postFile.seek(dataStart))
+    return false;
+
+  // Count the data lines, skipping empty lines and comments as in
+  // getPostLineStream(). Every nodes'th data line starts a new step.
+  qint64 first = (qint64)nodes * start;
+  qint64 last = (qint64)nodes * (end + 1);
+  qint64 lines = 0;
+  qint64 pos = dataStart;
+  bool lineStart = true;
+  bool done = false;
+
+  while(!done) {
+    QByteArray buffer = postFile.read(1 << 24);
+    if(buffer.isEmpty())
+      break;
+
+    const char *c = buffer.constData();
+
+    for(int i = 0; i < buffer.size(); i++, pos++) {
+      if(c[i] == '\n') {
+	lineStart = true;
+	continue;
+      }
+
+      if(!lineStart || isspace(c[i]))
+	continue;
+
+      lineStart = false;
+
+      if(c[i] == '#')
+	continue;
+
+      if((lines >= first) && ((lines - first) % nodes == 0)) {
+	stepOffset.push_back(pos);
+	if(lines == last) {
+	  done = true;
+	  break;
+	}
+      }
+
+      lines++;
+    }
+  }
+
+  // The end of file closes the last step if it is complete. Otherwise
+  // the start of the incomplete step closes the previous one:
+  if(!done && (lines > first) && ((lines - first) % nodes == 0))
+    stepOffset.push_back(pos);
+
+  postFile.close();
+
+  return true;
+}
+
+// Parse the data lines of one time step:
+//----------------------------------------------------------------------
+static void parsePostStep(const char *c, qint64 size, int nodes, 
+			  int components, double *value)
+{
+  QByteArray line;
+  qint64 i = 0;
+  int node = 0;
+
+  while((i < size) && (node < nodes)) {
+    qint64 j = i;
+    while((j < size) && (c[j] != '\n'))
+      j++;
+
+    // a terminated copy for strtod:
+    line.resize(j - i);
+    memcpy(line.data(), c + i, j - i);
+    i = j + 1;
+
+    const char *p = line.constData();
+    while(isspace(*p))
+      p++;
+
+    if((*p == '\0') || (*p == '#'))
+      continue;
+
+    double *v = &value[(qint64)node * components];
+    for(int k = 0; k < components; k++) {
+      char *q;
+      v[k] = strtod(p, &q);
+      if(q == p)
+	break;
+      p = q;
+    }
+
+    node++;
+  }
+}
+
+// Copy a time step of a lazily read post file to the scalar fields:
+//----------------------------------------------------------------------
+bool VtkPost::loadTimeStep(int step)
+{
+  if(!lazyPostFile)
+    return true;
+
+  int steps = stepOffset.count() - 1;
+  int nodes = epMesh->epNodes;
+  int components = stepFieldNames.count();
+
+  if(steps < 1)
+    return false;
+
+  if(step < 1) step = 1;
+  if(step > steps) step = steps;
+
+  if(step == currentStep)
+    return true;
+
+  // Recently used steps are kept in memory:
+  //-----------------------------------------
+  EpStep *epStep = NULL;
+
+  for(int i = 0; i < epStepCache.count(); i++) {
+    if(epStepCache.at(i)->step == step) {
+      epStep = epStepCache.takeAt(i);
+      break;
+    }
+  }
+
+  if(!epStep) {
+    QFile postFile(postFileName);
+
+    if(!postFile.open(QIODevice::ReadOnly))
+      return false;
+
+    qint64 offset = stepOffset[step - 1];
+    qint64 size = stepOffset[step] - offset;
+
+    epStep = new EpStep;
+    epStep->step = step;
+    epStep->values = nodes * components;
+    epStep->value = new double[epStep->values];
+    memset(epStep->value, 0, epStep->values * sizeof(double));
+
+    uchar *data = postFile.map(offset, size);
+
+    if(data) {
+      parsePostStep((const char *)data, size, nodes, components, epStep->value);
+      postFile.unmap(data);
+    } else {
+      postFile.seek(offset);
+      QByteArray buffer = postFile.read(size);
+      parsePostStep(buffer.constData(), buffer.size(), nodes, components, epStep->value);
+    }
+
+    postFile.close();
+
+    while(epStepCache.count() >= epStepCacheSize)
+      delete epStepCache.takeLast();
+  }
+
+  epStepCache.prepend(epStep);
+
+  // The fields hold the current step only:
+  //----------------------------------------
+  for(int j = 0; j < components; j++) {
+    for(int k = 0; k < scalarFields; k++) {
+      ScalarField *sf = &scalarField[k];
+
+      if((sf->name != stepFieldNames.at(j)) || (sf->values != nodes))
+	continue;
+
+      for(int i = 0; i < nodes; i++)
+	sf->value[i] = epStep->value[i * components + j];
+
+      minMax(sf);
+      break;
+    }
+  }
+
+  currentStep = step;
+
+  return true;
+}
+
+// Drop the lazily read time steps:
+//----------------------------------------------------------------------
+void VtkPost::clearStepCache()
+{
+  while(!epStepCache.isEmpty())
+    delete epStepCache.takeFirst();
+
+  currentStep = 0;
+}
+
 void VtkPost::addVectorField(QString fieldName, int values)
 {
    
@@ -1550,6 +1790,9 @@ void VtkPost::redrawSlot()
 {
   if(!postFileRead) return;
 
+  if(lazyPostFile)
+    loadTimeStep(timeStep->ui.timeStep->value());
+
 #ifdef EG_MATC
    VARIABLE *tvar = var_check((char *)"t");
    if (!tvar) tvar=var_new((char *)"t", TYPE_DOUBLE,1,1 );
@@ -43,8 +43,16 @@
 
 #define MAX_SCALARS 100
 
+// Ep-files with more data than EP_LAZY_LIMIT bytes are read one time step
+// at a time, keeping about EP_CACHE_LIMIT bytes of recent steps in memory:
+#define EP_LAZY_LIMIT 268435456
+#define EP_CACHE_LIMIT 268435456
+
 #include <QMainWindow>
 #include <QHash>
+#include <QList>
+#include <QVector>
+#include <QStringList>
 #include <QTextStream>
 
 #ifdef EG_PYTHONQT
@@ -53,6 +61,7 @@
 #endif
 
 class EpMesh;
+class EpStep;
 class ScalarField;
 class QVTKWidget;
 class vtkRenderer;
@@ -355,6 +364,18 @@ private:
   void addVectorField(QString, int);
   void getPostLineStream(QTextStream*);
 
+  // Lazily read time steps:
+  bool lazyPostFile;
+  QStringList stepFieldNames;    // fields in the data lines
+  QVector<qint64> stepOffset;    // file offsets of the steps, and the end
+  QList<EpStep*> epStepCache;    // most recently used first
+  int epStepCacheSize;
+  int currentStep;
+
+  bool indexPostFile(qint64, int, int, int);
+  bool loadTimeStep(int);
+  void clearStepCache();
+
   QHash<QString, QAction*> groupActionHash;
 
   QVTKWidget* qvtkWidget;
@@ -41,6 +41,9 @@
 #include <stdarg.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#if !defined(MINGW32) && !defined(_WIN32)
+#include <sys/resource.h>
+#endif
 
 #include "nrutil.h"
 #include "common.h"
@@ -1186,6 +1189,9 @@ int SaveElmerInput(struct FemType *data,struct BoundaryType *bound,
 
 
 
+  /* A binary mesh from earlier would otherwise be preferred by ElmerSolver */
+  remove("mesh.bin");
+
   sprintf(filename,"%s","mesh.nodes");
   out = fopen(filename,"w");
 
@@ -1368,6 +1374,402 @@ int SaveElmerInput(struct FemType *data,struct BoundaryType *bound,
 
 
 
+/* The binary mesh container read by ElmerSolver as an alternative to the 
+   ascii files. All integers are 4 bytes and reals 8 bytes in native byte order.
+   The header is followed by the nodes, bulk elements, boundary elements and
+   shared nodes, each stored as contiguous arrays. */
+#define ELMERBIN_MAGIC "ELMERBIN"
+#define ELMERBIN_VERSION 1
+#define ELMERBIN_HEADERINTS 10
+#define ELMERBIN_MAXLINE 4096
+
+
+static int ElmerBinaryInts(char *line,int *ivals,int maxvals,int *halo)
+/* Reads the integers of an element or shared node line. The slash marking 
+   the partition of halo elements is treated as a separator. */
+{
+  char *p,*q;
+  int n;
+  long val;
+
+  n = 0;
+  *halo = FALSE;
+  p = line;
+  while(n < maxvals) {
+    while(*p == ' ' || *p == '\t' || *p == '/') {
+      if(*p == '/') *halo = TRUE;
+      p++;
+    }
+    val = strtol(p,&q,10);
+    if(q == p) break;
+    ivals[n++] = (int)val;
+    p = q;
+  }
+  return(n);
+}
+
+
+static int *ElmerBinaryGrow(int *vec,int *size,int needed)
+{
+  int newsize;
+  if(needed <= *size) return(vec);
+  newsize = MAX(2*(*size),needed);
+  vec = (int*)realloc(vec,newsize*sizeof(int));
+  if(!vec) {
+    printf("ElmerBinaryGrow: could not allocate %d integers\n",newsize);
+    bigerror("Memory allocation failed");
+  }
+  *size = newsize;
+  return(vec);
+}
+
+
+static int ElmerBinaryLine(FILE *in,char **line,int *linesize,int **ivals,int *ivalsize)
+/* Reads a whole line of any length and makes sure that 'ivals' can hold all
+   the integers on it. Each integer takes at least two characters. */
+{
+  int len;
+
+  if(!fgets(*line,*linesize,in)) return(FALSE);
+  len = strlen(*line);
+  while(len == *linesize-1 && (*line)[len-1] != '\n') {
+    *linesize *= 2;
+    *line = (char*)realloc(*line,*linesize);
+    if(!*line) bigerror("Memory allocation failed");
+    if(!fgets(*line+len,*linesize-len,in)) break;
+    len += strlen(*line+len);
+  }
+  *ivals = ElmerBinaryGrow(*ivals,ivalsize,len/2+1);
+  return(TRUE);
+}
+
+
+static int ElmerBinaryConvert(char *prefix,int info)
+/* Converts the ascii mesh files 'prefix.header', 'prefix.nodes', 'prefix.elements', 
+   'prefix.boundary' and 'prefix.shared' in the current directory to a single 
+   binary file 'prefix.bin'. The conversion is done from the ascii files since 
+   then the serial and partitioned writers share the same definition. */
+{
+  FILE *in,*out;
+  char filename[MAXFILESIZE],*line;
+  int i,j,n,halo,ioffset,nread,*ivals,ivalsize,linesize,status;
+  int noknots,noelements,nosides,noshared,maxnodes;
+  int bulkconn,sideconn,sharedconn,bulksize,sidesize,sharedsize;
+  int header[ELMERBIN_HEADERINTS];
+  int *nodetags,*bulktags,*bulkparts,*bodies,*bulktypes,*bulkind;
+  int *sidetags,*sideparts,*constraints,*left,*right,*sidetypes,*sideind;
+  int *sharedtags,*sharedcounts,*sharedparts;
+  double *x,*y,*z;
+
+  in = out = NULL;
+  nodetags = bulktags = bulkparts = bodies = bulktypes = bulkind = NULL;
+  sidetags = sideparts = constraints = left = right = sidetypes = sideind = NULL;
+  sharedtags = sharedcounts = sharedparts = NULL;
+  x = y = z = NULL;
+  noknots = noelements = nosides = noshared = 0;
+  status = 0;
+
+  linesize = ELMERBIN_MAXLINE;
+  line = (char*)malloc(linesize);
+  ivalsize = MAXNODESD3+8;
+  ivals = (int*)malloc(ivalsize*sizeof(int));
+
+  sprintf(filename,"%s.header",prefix);
+  in = fopen(filename,"r");
+  if(in == NULL) {
+    printf("ElmerBinaryConvert: could not open file %s\n",filename);
+    status = 1;
+    goto cleanup;
+  }
+  if(fscanf(in,"%d %d %d",&noknots,&noelements,&nosides) != 3) {
+    printf("ElmerBinaryConvert: could not read sizes from %s\n",filename);
+    noknots = noelements = nosides = 0;
+    status = 1;
+    goto cleanup;
+  }
+  fclose(in);
+  in = NULL;
+
+  if(info) printf("Saving mesh %s in binary format to %s.bin\n",prefix,prefix);
+
+  /* Nodes */
+  nodetags = Ivector(1,noknots);
+  x = Rvector(1,noknots);
+  y = Rvector(1,noknots);
+  z = Rvector(1,noknots);
+
+  sprintf(filename,"%s.nodes",prefix);
+  in = fopen(filename,"r");
+  if(in == NULL) {
+    printf("ElmerBinaryConvert: could not open file %s\n",filename);
+    status = 2;
+    goto cleanup;
+  }
+  for(i=1;i<=noknots;i++) {
+    if(fscanf(in,"%d %d %le %le %le",&nodetags[i],&j,&x[i],&y[i],&z[i]) != 5) {
+      printf("ElmerBinaryConvert: could not read node %d from %s\n",i,filename);
+      status = 2;
+      goto cleanup;
+    }
+  }
+  fclose(in);
+  in = NULL;
+
+  /* Bulk elements */
+  maxnodes = 0;
+  bulktags = Ivector(1,noelements);
+  bulkparts = Ivector(1,noelements);
+  bodies = Ivector(1,noelements);
+  bulktypes = Ivector(1,noelements);
+  bulksize = 4*noelements+1;
+  bulkind = (int*)malloc(bulksize*sizeof(int));
+  bulkconn = 0;
+
+  sprintf(filename,"%s.elements",prefix);
+  in = fopen(filename,"r");
+  if(in == NULL) {
+    printf("ElmerBinaryConvert: could not open file %s\n",filename);
+    status = 3;
+    goto cleanup;
+  }
+  for(i=1;i<=noelements;i++) {
+    if(!ElmerBinaryLine(in,&line,&linesize,&ivals,&ivalsize)) {
+      printf("ElmerBinaryConvert: could not read element %d from %s\n",i,filename);
+      status = 3;
+      goto cleanup;
+    }
+    nread = ElmerBinaryInts(line,ivals,ivalsize,&halo);
+    ioffset = halo ? 1 : 0;
+    n = nread - ioffset - 3;
+    if(n <= 0) {
+      printf("ElmerBinaryConvert: too few entries for element %d in %s\n",i,filename);
+      status = 3;
+      goto cleanup;
+    }
+    bulktags[i] = ivals[0];
+    bulkparts[i] = halo ? ivals[1] : 0;
+    bodies[i] = ivals[ioffset+1];
+    bulktypes[i] = ivals[ioffset+2];
+    maxnodes = MAX(maxnodes,n);
+    bulkind = ElmerBinaryGrow(bulkind,&bulksize,bulkconn+n);
+    for(j=0;j<n;j++) bulkind[bulkconn++] = ivals[ioffset+3+j];
+  }
+  fclose(in);
+  in = NULL;
+
+  /* Boundary elements */
+  sidetags = Ivector(1,MAX(1,nosides));
+  sideparts = Ivector(1,MAX(1,nosides));
+  constraints = Ivector(1,MAX(1,nosides));
+  left = Ivector(1,MAX(1,nosides));
+  right = Ivector(1,MAX(1,nosides));
+  sidetypes = Ivector(1,MAX(1,nosides));
+  sidesize = 2*nosides+1;
+  sideind = (int*)malloc(sidesize*sizeof(int));
+  sideconn = 0;
+
+  sprintf(filename,"%s.boundary",prefix);
+  in = fopen(filename,"r");
+  if(in == NULL && nosides > 0) {
+    printf("ElmerBinaryConvert: could not open file %s\n",filename);
+    status = 4;
+    goto cleanup;
+  }
+  for(i=1;i<=nosides;i++) {
+    if(!ElmerBinaryLine(in,&line,&linesize,&ivals,&ivalsize)) {
+      printf("ElmerBinaryConvert: could not read boundary element %d from %s\n",i,filename);
+      status = 4;
+      goto cleanup;
+    }
+    nread = ElmerBinaryInts(line,ivals,ivalsize,&halo);
+    ioffset = halo ? 1 : 0;
+    n = nread - ioffset - 5;
+    if(n <= 0) {
+      printf("ElmerBinaryConvert: too few entries for boundary element %d in %s\n",i,filename);
+      status = 4;
+      goto cleanup;
+    }
+    sidetags[i] = ivals[0];
+    sideparts[i] = halo ? ivals[1] : 0;
+    constraints[i] = ivals[ioffset+1];
+    left[i] = ivals[ioffset+2];
+    right[i] = ivals[ioffset+3];
+    sidetypes[i] = ivals[ioffset+4];
+    maxnodes = MAX(maxnodes,n);
+    sideind = ElmerBinaryGrow(sideind,&sidesize,sideconn+n);
+    for(j=0;j<n;j++) sideind[sideconn++] = ivals[ioffset+5+j];
+  }
+  if(in) fclose(in);
+  in = NULL;
+
+  /* Shared nodes, exist only for partitioned meshes. The number of partitions 
+     sharing a node is not limited, so the lines are parsed in full. */
+  sharedconn = 0;
+  sharedsize = 1;
+  sharedparts = (int*)malloc(sharedsize*sizeof(int));
+
+  sprintf(filename,"%s.shared",prefix);
+  in = fopen(filename,"r");
+  if(in) {
+    while(ElmerBinaryLine(in,&line,&linesize,&ivals,&ivalsize)) 
+      if(ElmerBinaryInts(line,ivals,2,&halo) == 2) noshared++;
+    rewind(in);
+
+    sharedtags = Ivector(1,MAX(1,noshared));
+    sharedcounts = Ivector(1,MAX(1,noshared));
+    sharedparts = ElmerBinaryGrow(sharedparts,&sharedsize,2*noshared+1);
+
+    for(i=1;i<=noshared;i++) {
+      nread = 0;
+      while(ElmerBinaryLine(in,&line,&linesize,&ivals,&ivalsize)) {
+	nread = ElmerBinaryInts(line,ivals,ivalsize,&halo);
+	if(nread >= 2) break;
+      }
+      n = nread >= 2 ? ivals[1] : 0;
+      if(nread < 2 || n < 0 || nread < n+2) {
+	printf("ElmerBinaryConvert: too few entries for shared node %d in %s\n",i,filename);
+	status = 5;
+	goto cleanup;
+      }
+      sharedtags[i] = ivals[0];
+      sharedcounts[i] = n;
+      sharedparts = ElmerBinaryGrow(sharedparts,&sharedsize,sharedconn+n);
+      for(j=0;j<n;j++) sharedparts[sharedconn++] = ivals[2+j];
+    }
+    fclose(in);
+    in = NULL;
+  }
+
+  /* Write everything in one go */
+  sprintf(filename,"%s.bin",prefix);
+  out = fopen(filename,"wb");
+  if(out == NULL) {
+    printf("ElmerBinaryConvert: could not open file %s for writing\n",filename);
+    status = 6;
+    goto cleanup;
+  }
+
+  header[0] = ELMERBIN_VERSION;
+  header[1] = 1; /* byte order mark */
+  header[2] = noknots;
+  header[3] = noelements;
+  header[4] = nosides;
+  header[5] = noshared;
+  header[6] = bulkconn;
+  header[7] = sideconn;
+  header[8] = sharedconn;
+  header[9] = maxnodes;
+
+  fwrite(ELMERBIN_MAGIC,sizeof(char),8,out);
+  fwrite(header,sizeof(int),ELMERBIN_HEADERINTS,out);
+
+  fwrite(&nodetags[1],sizeof(int),noknots,out);
+  fwrite(&x[1],sizeof(double),noknots,out);
+  fwrite(&y[1],sizeof(double),noknots,out);
+  fwrite(&z[1],sizeof(double),noknots,out);
+
+  fwrite(&bulktags[1],sizeof(int),noelements,out);
+  fwrite(&bulkparts[1],sizeof(int),noelements,out);
+  fwrite(&bodies[1],sizeof(int),noelements,out);
+  fwrite(&bulktypes[1],sizeof(int),noelements,out);
+  fwrite(bulkind,sizeof(int),bulkconn,out);
+
+  fwrite(&sidetags[1],sizeof(int),nosides,out);
+  fwrite(&sideparts[1],sizeof(int),nosides,out);
+  fwrite(&constraints[1],sizeof(int),nosides,out);
+  fwrite(&left[1],sizeof(int),nosides,out);
+  fwrite(&right[1],sizeof(int),nosides,out);
+  fwrite(&sidetypes[1],sizeof(int),nosides,out);
+  fwrite(sideind,sizeof(int),sideconn,out);
+
+  if(noshared) {
+    fwrite(&sharedtags[1],sizeof(int),noshared,out);
+    fwrite(&sharedcounts[1],sizeof(int),noshared,out);
+    fwrite(sharedparts,sizeof(int),sharedconn,out);
+  }
+
+  if(ferror(out)) {
+    printf("ElmerBinaryConvert: writing of file %s failed\n",filename);
+    status = 6;
+  }
+  fclose(out);
+  /* Do not leave a truncated file to be read by the solver */
+  if(status) remove(filename);
+
+cleanup:
+  if(in) fclose(in);
+
+  if(nodetags) free_Ivector(nodetags,1,noknots);
+  if(x) free_Rvector(x,1,noknots);
+  if(y) free_Rvector(y,1,noknots);
+  if(z) free_Rvector(z,1,noknots);
+  if(bulktags) free_Ivector(bulktags,1,noelements);
+  if(bulkparts) free_Ivector(bulkparts,1,noelements);
+  if(bodies) free_Ivector(bodies,1,noelements);
+  if(bulktypes) free_Ivector(bulktypes,1,noelements);
+  free(bulkind);
+  if(sidetags) free_Ivector(sidetags,1,MAX(1,nosides));
+  if(sideparts) free_Ivector(sideparts,1,MAX(1,nosides));
+  if(constraints) free_Ivector(constraints,1,MAX(1,nosides));
+  if(left) free_Ivector(left,1,MAX(1,nosides));
+  if(right) free_Ivector(right,1,MAX(1,nosides));
+  if(sidetypes) free_Ivector(sidetypes,1,MAX(1,nosides));
+  free(sideind);
+  if(sharedtags) free_Ivector(sharedtags,1,MAX(1,noshared));
+  if(sharedcounts) free_Ivector(sharedcounts,1,MAX(1,noshared));
+  free(sharedparts);
+  free(ivals);
+  free(line);
+
+  return(status);
+}
+
+
+int SaveElmerInputBinary(char *prefix,int info)
+/* Converts the serial mesh saved in directory 'prefix' to binary format. */
+{
+  int cdstat,fail;
+
+  cdstat = chdir(prefix);
+  if(cdstat) {
+    printf("SaveElmerInputBinary: could not enter directory %s\n",prefix);
+    return(1);
+  }
+  fail = ElmerBinaryConvert("mesh",info);
+  cdstat = chdir("..");
+
+  return(fail);
+}
+
+
+int SaveElmerInputBinaryPartitioned(char *prefix,int partitions,int info)
+/* Converts all the partitions of an already saved mesh to binary format. */
+{
+  char partname[MAXFILESIZE],dirname[MAXFILESIZE];
+  int part,cdstat,fail;
+
+  sprintf(dirname,"%s/%s.%d",prefix,"partitioning",partitions);
+  cdstat = chdir(dirname);
+  if(cdstat) {
+    printf("SaveElmerInputBinaryPartitioned: could not enter directory %s\n",dirname);
+    return(1);
+  }
+
+  fail = 0;
+  for(part=1;part<=partitions;part++) {
+    sprintf(partname,"%s.%d","part",part);
+    fail = ElmerBinaryConvert(partname,info && part==1);
+    if(fail) break;
+  }
+  if(info && !fail) printf("Saved %d partitions in binary format\n",partitions);
+
+  cdstat = chdir("..");
+  cdstat = chdir("..");
+
+  return(fail);
+}
+
+
 int SaveSizeInfo(struct FemType *data,struct BoundaryType *bound,
 		 char *prefix,int info)
 {
@@ -3900,10 +4302,10 @@ int PartitionMetisGraph(struct FemType *data,struct BoundaryType *bound,
    the ownership of the nodes will follow. The latter is optimal for Elmer. */
 {
   int i,j,k,noelements,noknots,errstat;
-  int nn,ncon,con,maxcon,totcon;
-  int *xadj,*adjncy,*vwgt,*adjwgt,wgtflag,*npart,**graph;
+  int nn,ncon,maxcon,totcon;
+  int *xadj,*adjncy,*vwgt,*adjwgt,wgtflag,*npart;
   int numflag,nparts,edgecut,maxconset;
-  struct CRSType *dualgraph;
+  struct CRSType *graph;
   idx_t options[METIS_NOPTIONS];
 
   if(info) printf("Making a Metis partitioning for %d nodes in %d-dimensions.\n",
@@ -3952,48 +4354,20 @@ int PartitionMetisGraph(struct FemType *data,struct BoundaryType *bound,
 
     CreateDualGraph(data,TRUE,info);
 
-    /* Create the sparse matrix format graph for Metis */
-    dualgraph = &data->dualgraph; 
-    
-    nn = dualgraph->rowsize;
-    xadj = dualgraph->rows;
-    adjncy = dualgraph->cols;
-    totcon = dualgraph->colsize;
+    /* The dual graph is already in the sparse matrix format used by Metis */
+    graph = &data->dualgraph; 
   }
   else {
+    /* And so is the nodal graph */
     CreateNodalGraph(data,TRUE,info);
     maxcon = data->nodalmaxconnections;
-    nn = noknots;
-    graph = data->nodalgraph;
-
-    /* Compute total number of connections in graph */
-    totcon = 0;
-    for(i=1;i<=nn;i++) {
-      for(j=0;j<maxcon;j++) {
-        con = graph[j][i];
-        if(con) totcon++;
-      }
-    }
-    
-    /* Create the sparse matrix format graph for Metis */
-    xadj = Ivector(0,nn);
-    adjncy = Ivector(0,totcon-1);
-    for(i=0;i<totcon;i++) 
-      adjncy[i] = 0;
-    
-    totcon = 0;
-    for(i=1;i<=nn;i++) {
-      xadj[i-1] = totcon;
-      for(j=0;j<maxcon;j++) {
-        con = graph[j][i];
-        if(con) {
-          adjncy[totcon] = con-1;
-          totcon++;
-        }
-      }
-    }
-    xadj[nn] = totcon;
+    graph = &data->nodalgraph;
   }
+  
+  nn = graph->rowsize;
+  xadj = graph->rows;
+  adjncy = graph->cols;
+  totcon = xadj[nn];
 
   if(info) printf("There are %d connections alltogether in the graph.\n",totcon);
 
@@ -4116,9 +4490,11 @@ int PartitionMetisGraph(struct FemType *data,struct BoundaryType *bound,
   if(info) printf("Finished Metis graph partitioning call.\n");
 
 
-  free_Ivector(adjncy,0,totcon-1);
-  free_Ivector(xadj,0,nn);
-  if(wgtflag == 1)  free_Ivector(adjwgt,0,totcon-1);
+  if( dual ) 
+    DestroyDualGraph(data,info);
+  else
+    DestroyNodalGraph(data,info);
+  if(adjwgt) free_Ivector(adjwgt,0,totcon-1);
 
  skippart:
 
@@ -5099,6 +5475,47 @@ int OptimizePartitioning(struct FemType *data,struct BoundaryType *bound,int noo
 }
 
 
+static int PartitionFileSetSize(int partitions)
+/* Returns how many partition files may be kept open at the same time. This follows 
+   the soft limit of open files of the process, which is not altered here. */
+{
+  int setsize;
+
+  setsize = MAXPARTITIONS;
+#if !defined(MINGW32) && !defined(_WIN32)
+  {
+    struct rlimit rl;
+    if( getrlimit(RLIMIT_NOFILE,&rl) == 0 ) {
+      if( rl.rlim_cur == RLIM_INFINITY ) 
+	setsize = partitions;
+      else 
+	setsize = MAX( 16, (int) rl.rlim_cur - 64 );
+    }
+  }
+#endif
+  return( MIN( setsize, MAX( partitions, 1) ) );
+}
+
+
+static int CompareInts(const void *a,const void *b)
+{
+  int ia = *(const int*)a, ib = *(const int*)b;
+  return( (ia > ib) - (ia < ib) );
+}
+
+
+static int ConnectedNodeIndex(int ind,int *connnodes,int connectednodes)
+/* Returns the position of node ind in the sorted list connnodes[1..connectednodes], 
+   or zero if the node has no connections. */
+{
+  int *hit;
+  if(connectednodes < 1) return(0);
+  hit = (int*) bsearch(&ind,&connnodes[1],(size_t) connectednodes,sizeof(int),CompareInts);
+  if(!hit) return(0);
+  return( (int) (hit - connnodes) );
+}
+
+
 int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
 			      char *prefix,int decimals,int halomode,int indirect,
 			      int parthypre,int subparts,int nooverwrite, int info)
@@ -5106,22 +5523,24 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
    in Elmer calculations in parallel platforms. 
    */
 {
-  int noknots,noelements,sumsides,partitions,hit,found,parent,parent2,maxnosides;
-  int nodesd2,nodesd1,discont,maxelemtype,minelemtype,sidehits,elemsides,side,bctype;
+  int noknots,noelements,partitions,hit,found,parent,parent2;
+  int nodesd2,nodesd1,maxelemtype,minelemtype,sidehits,elemsides,side,bctype;
   int part,otherpart,part2,part3,elemtype,sideelemtype,*needednodes,*neededtwice;
-  int **bulktypes,*sidetypes,tottypes,splitsides;
+  int **bulktypes,splitsides;
   int i,j,k,l,l2,l3,m,n,ind,ind2,sideind[MAXNODESD1],elemhit[MAXNODESD2];
   char filename[MAXFILESIZE],outstyle[MAXFILESIZE];
   char directoryname[MAXFILESIZE],subdirectoryname[MAXFILESIZE];
   int *neededtimes,*elempart,*elementsinpart,*indirectinpart,*sidesinpart;
   int maxneededtimes,indirecttype,bcneeded,trueparent,trueparent2,*ownerpart;
   int *sharednodes,*ownnodes,reorder,*order=NULL,*invorder=NULL;
-  int *bcnodesaved[MAXBCS],maxbcnodesaved,*bcelemsaved,*bcnode;
-  int *bcnodedummy,*elementhalo,*neededtimes2;
+  int *bcnodesaved[MAXBCS],maxbcnodesaved,*bcnode;
+  int *elementhalo,*neededtimes2,*partmark;
+  int *bcstart,*bcboundary=NULL,*bcside=NULL,nobcsides,*discstart,*discboundary,*discside,nodiscsides;
+  int *ownstart=NULL,*ownelems=NULL,*indstart=NULL,*indelems=NULL;
   int partstart,partfin,filesetsize,nofile,nofile2,nobcnodes;
-  int halobulkelems,halobcs,savethis,fail=0,cdstat;
+  int halobulkelems,halobcs,savethis,fail=0,openfail,cdstat;
 
-  FILE *out,*outfiles[MAXPARTITIONS+1];
+  FILE *out,**outfiles;
   int sumelementsinpart,sumownnodes,sumsharednodes,sumsidesinpart,sumindirect;
 
   if(info) {
@@ -5161,9 +5580,7 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
   neededtwice = Ivector(1,partitions);
   sharednodes = Ivector(1,partitions);
   ownnodes = Ivector(1,partitions);
-  sidetypes = Ivector(minelemtype,maxelemtype);
   bulktypes =  Imatrix(1,partitions,minelemtype,maxelemtype);
-  bcnodedummy = Ivector(1,noknots);
 
   /* Order the nodes so that the different partitions have a continuous interval of nodes.
      This information is used only just before the saving of node indexes in each instance. 
@@ -5239,9 +5656,10 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
   if(info) printf("Saving mesh in parallel ElmerSolver format to directory %s/%s.\n",
 		  directoryname,subdirectoryname);
 
-  filesetsize = MAXPARTITIONS;
+  filesetsize = PartitionFileSetSize(partitions);
   if(partitions > filesetsize) 
     if(info) printf("Saving %d partitions in maximum sets of %d\n",partitions,filesetsize);
+  outfiles = (FILE**) malloc((size_t) (filesetsize+2)*sizeof(FILE*));
 
   elementsinpart = Ivector(1,partitions);
   indirectinpart = Ivector(1,partitions);
@@ -5710,222 +6128,358 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
 
    
   /*********** part.n.boundary *********************/
-  /* This is still done in partition loop as the subroutines are quite complicated */
+  /* The boundary elements, and the elements that may cause indirect couplings, are 
+     first listed for each partition in one sweep over the mesh. Thereafter each partition 
+     only visits its own candidates and the partitions may be saved concurrently. */
+
+  /* Partitions that a boundary element may belong to: those that own any of its nodes. 
+     The lists are in the same order as the boundary elements. */
+  bcstart = Ivector(1,partitions+1);
+  partmark = Ivector(1,partitions);
+  for(part=1;part<=partitions;part++) 
+    bcstart[part] = partmark[part] = 0;
+  
+  for(l3=0;l3<2;l3++) {
+    nobcsides = 0;
+    for(j=0;j < MAXBOUNDARIES;j++) {
+      for(i=1; i <= bound[j].nosides; i++) {
+	nobcsides++;
+	GetBoundaryElement(i,&bound[j],data,sideind,&sideelemtype); 
+	nodesd1 = sideelemtype%100;
+	for(l=0;l<nodesd1;l++) {
+	  ind = sideind[l];
+	  for(k=1;k<=neededtimes[ind];k++) {
+	    part = data->partitiontable[k][ind];
+	    if(partmark[part] == nobcsides) continue;
+	    partmark[part] = nobcsides;
+	    if(l3 == 0) {
+	      bcstart[part] += 1;
+	    }
+	    else {
+	      bcboundary[bcstart[part]] = j;
+	      bcside[bcstart[part]] = i;
+	      bcstart[part] += 1;
+	    }
+	  }
+	}
+      }
+    }
+    if(l3 == 0) {
+      for(part=1,k=0;part<=partitions;part++) {
+	l = bcstart[part];
+	bcstart[part] = k;
+	k += l;
+      }
+      bcstart[partitions+1] = k;
+      bcboundary = Ivector(0,MAX(k,1));
+      bcside = Ivector(0,MAX(k,1));
+      for(part=1;part<=partitions;part++) 
+	partmark[part] = 0;
+    }
+    else {
+      for(part=partitions;part>=2;part--)
+	bcstart[part] = bcstart[part-1];
+      bcstart[1] = 0;
+    }
+  }
+
+  /* The second side of discontinuous boundaries is only saved by the owner of the parent */
+  discstart = Ivector(1,partitions+1);
+  for(part=1;part<=partitions+1;part++) 
+    discstart[part] = 0;
+  nodiscsides = 0;
+  for(j=0;j < MAXBOUNDARIES;j++) {
+    if(!bound[j].ediscont) continue;
+    for(i=1; i <= bound[j].nosides; i++) {
+      if(!bound[j].parent2[i] || !bound[j].discont[i]) continue;
+      discstart[elempart[bound[j].parent2[i]]] += 1;
+      nodiscsides++;
+    }
+  }
+  for(part=1,k=0;part<=partitions+1;part++) {
+    l = discstart[part];
+    discstart[part] = k;
+    k += l;
+  }
+  discboundary = Ivector(0,MAX(nodiscsides,1));
+  discside = Ivector(0,MAX(nodiscsides,1));
+  for(j=0;j < MAXBOUNDARIES;j++) {
+    if(!bound[j].ediscont) continue;
+    for(i=1; i <= bound[j].nosides; i++) {
+      if(!bound[j].parent2[i] || !bound[j].discont[i]) continue;
+      part = elempart[bound[j].parent2[i]];
+      discboundary[discstart[part]] = j;
+      discside[discstart[part]] = i;
+      discstart[part] += 1;
+    }
+  }
+  for(part=partitions;part>=2;part--)
+    discstart[part] = discstart[part-1];
+  discstart[1] = 0;
 
+  /* For the indirect couplings list the owned elements, and the foreign elements having 
+     at least two nodes in the partition, for each partition. */
+  if(indirect) {
+    ownstart = Ivector(1,partitions+1);
+    indstart = Ivector(1,partitions+1);
+    for(part=1;part<=partitions+1;part++) 
+      ownstart[part] = indstart[part] = 0;
+    for(part=1;part<=partitions;part++) 
+      partmark[part] = 0;
+    
+    for(l3=0;l3<2;l3++) {
+      for(i=1;i<=noelements;i++) {
+	if(l3 == 0) 
+	  ownstart[elempart[i]] += 1;
+	else {
+	  ownelems[ownstart[elempart[i]]] = i;
+	  ownstart[elempart[i]] += 1;
+	}
+	nodesd2 = data->elementtypes[i] % 100;
+	for(j=0;j < nodesd2;j++) {
+	  ind = data->topology[i][j];
+	  for(k=1;k<=neededtimes[ind];k++) {
+	    part = data->partitiontable[k][ind];
+	    if(part == elempart[i]) continue;
+	    /* partmark counts the hits of this element, the 2nd hit adds a candidate */
+	    if(partmark[part] / 2 != i) partmark[part] = 2*i;
+	    else if(partmark[part] == 2*i) {
+	      partmark[part] = 2*i+1;
+	      if(l3 == 0) 
+		indstart[part] += 1;
+	      else {
+		indelems[indstart[part]] = i;
+		indstart[part] += 1;
+	      }
+	    }
+	  }
+	}
+      }
+      if(l3 == 0) {
+	for(part=1,k=0,l2=0;part<=partitions+1;part++) {
+	  l = ownstart[part];
+	  ownstart[part] = k;
+	  k += l;
+	  l = indstart[part];
+	  indstart[part] = l2;
+	  l2 += l;
+	}
+	ownelems = Ivector(0,MAX(k,1));
+	indelems = Ivector(0,MAX(l2,1));
+	for(part=1;part<=partitions;part++) 
+	  partmark[part] = 0;
+      }
+      else {
+	for(part=partitions;part>=2;part--) {
+	  ownstart[part] = ownstart[part-1];
+	  indstart[part] = indstart[part-1];
+	}
+	ownstart[1] = indstart[1] = 0;
+      }
+    }
+  }
+  free_Ivector(partmark,1,partitions);
+  
+  /* Memorize the different boundary types of the boundary nodes. This is only used 
+     to report how many boundary elements a node is needed in at maximum. */
   maxbcnodesaved = 1;
-  bcnodesaved[1] = Ivector(1,nobcnodes);
+  bcnodesaved[1] = Ivector(1,MAX(nobcnodes,1));
+  for(i=1;i<=nobcnodes;i++)
+    bcnodesaved[1][i] = 0;
+  for(j=0;j < MAXBOUNDARIES;j++) {
+    for(i=1; i <= bound[j].nosides; i++) {
+      GetBoundaryElement(i,&bound[j],data,sideind,&sideelemtype); 
+      bctype = bound[j].types[i];
+      nodesd1 = sideelemtype%100;
+      for(l=0;l<nodesd1;l++) {
+	k = bcnode[sideind[l]];
+	found = FALSE;
+	for(l2=1;l2<=maxbcnodesaved;l2++) {
+	  if(bcnodesaved[l2][k] == bctype ) {
+	    found = TRUE;
+	    break;
+	  }
+	  if(bcnodesaved[l2][k] == 0 ) {
+	    bcnodesaved[l2][k] = bctype;
+	    found = TRUE;
+	    break;
+	  }
+	}
+	if( !found ) {
+	  maxbcnodesaved += 1;
+	  bcnodesaved[maxbcnodesaved] = Ivector(1,nobcnodes);
+	  for(l3=1;l3<=nobcnodes;l3++)
+	    bcnodesaved[maxbcnodesaved][l3] = 0;
+	  bcnodesaved[maxbcnodesaved][k] = bctype;
+	}
+      }
+    }
+  }
 
-  discont = FALSE;
   splitsides = 0;
+  halobcs = 0;
+  openfail = 0;
 
-  maxnosides = 0;
-  for(j=0;j < MAXBOUNDARIES;j++) 
-    maxnosides = MAX( maxnosides, bound[j].nosides );
-  bcelemsaved = Ivector(1,maxnosides);
+#pragma omp parallel 
+  {
+    int *sidetypes,*conncount=NULL,*connnodes=NULL;
+    
+    sidetypes = Ivector(minelemtype,maxelemtype);
 
-  halobcs = 0;
+#pragma omp for schedule(dynamic,1) reduction(+:splitsides,halobcs,openfail)
   for(part=1;part<=partitions;part++) { 
-    int bcneeded2,closeparent,closeparent2,haloelem;
+    int i,j,k,l,l2,ind,ind2,bc,sumsides,tottypes,sideind[MAXNODESD1],elemhit[MAXNODESD2];
+    int nodesd1,nodesd2,sideelemtype,elemtype,bctype,parent,parent2,bcneeded,bcneeded2;
+    int trueparent,trueparent2,closeparent,closeparent2,haloelem;
+    char filename[MAXFILESIZE];
+    FILE *out;
 
     sprintf(filename,"%s.%d.%s","part",part,"boundary");
     out = fopen(filename,"w");
+    if(out == NULL) {
+      printf("Could not open file for writing: %s\n",filename);
+      openfail++;
+      continue;
+    }
 
-    for(j=1;j<=maxbcnodesaved;j++)
-      for(i=1;i<=nobcnodes;i++)
-	bcnodesaved[j][i] = FALSE;
-   
     for(i=minelemtype;i<=maxelemtype;i++)
       sidetypes[i] = 0;
     
     sumsides = 0;
 
-    /* First loop the standard elements, 2nd time the orphan nodes */
-    for(j=0;j < MAXBOUNDARIES;j++) {
-
-      if(bound[j].nosides == 0 ) continue;
-
-      for(i=1;i<=maxnosides;i++)
-	bcelemsaved[i] = FALSE;
-
-
-      /* Normal boundary conditions */
-      for(i=1; i <= bound[j].nosides; i++) {
+    /* Normal boundary conditions */
+    for(bc=bcstart[part];bc<bcstart[part+1];bc++) {
+      j = bcboundary[bc];
+      i = bcside[bc];
 	  
-	GetBoundaryElement(i,&bound[j],data,sideind,&sideelemtype); 
-	/* GetElementSide(bound[j].parent[i],bound[j].side[i],bound[j].normal[i],
-	   data,sideind,&sideelemtype); */
+      GetBoundaryElement(i,&bound[j],data,sideind,&sideelemtype); 
 
-	bctype = bound[j].types[i];
-	nodesd1 = sideelemtype%100;
+      bctype = bound[j].types[i];
+      nodesd1 = sideelemtype%100;
 	  
-	parent = bound[j].parent[i];
-	parent2 = bound[j].parent2[i];
+      parent = bound[j].parent[i];
+      parent2 = bound[j].parent2[i];
 	  
-	bcneeded = 0;
+      bcneeded = 0;
+      for(l=0;l<nodesd1;l++) {
+	ind = sideind[l];
+	for(k=1;k<=neededtimes[ind];k++)
+	  if(part == data->partitiontable[k][ind]) bcneeded++;	   
+      }
+      if(!bcneeded) continue;
+
+      bcneeded2 = bcneeded;
+      if( halomode ) {
 	for(l=0;l<nodesd1;l++) {
 	  ind = sideind[l];
-	  for(k=1;k<=neededtimes[ind];k++)
-	    if(part == data->partitiontable[k][ind]) bcneeded++;	   
-	}
-	if(!bcneeded) continue;
-
-	bcneeded2 = bcneeded;
-	if( halomode ) {
-	  for(l=0;l<nodesd1;l++) {
-	    ind = sideind[l];
-	    for(k=neededtimes[ind]+1;k<=neededtimes2[ind];k++)	      
-	      if(part == data->partitiontable[k][ind]) bcneeded2++;
-	  }
+	  for(k=neededtimes[ind]+1;k<=neededtimes2[ind];k++)	      
+	    if(part == data->partitiontable[k][ind]) bcneeded2++;
 	}
+      }
 
-	haloelem = FALSE;
+      haloelem = FALSE;
 
-	/* Check whether the side is such that it belongs to the domain */
-	trueparent = trueparent2 = FALSE;
-	if( parent ) trueparent = (elempart[parent] == part);
-	if( parent2 ) trueparent2 = (elempart[parent2] == part);
+      /* Check whether the side is such that it belongs to the domain */
+      trueparent = trueparent2 = FALSE;
+      if( parent ) trueparent = (elempart[parent] == part);
+      if( parent2 ) trueparent2 = (elempart[parent2] == part);
 	      
-	if(trueparent || trueparent2) {
-	  /* Either parent must be associated with this partition, otherwise do not save this (except for halo nodes) */
-	  if( parent && !trueparent ) {	  
-	    splitsides++;
-	    if(halomode != 1 && halomode != 2) parent = 0;
-	  }
-	  else if( parent2 && !trueparent2 ) {
-	    splitsides++;
-	    if(!halomode != 1 && halomode != 2) parent2 = 0;
-	  }
+      if(trueparent || trueparent2) {
+	/* Either parent must be associated with this partition, otherwise do not save this (except for halo nodes) */
+	if( parent && !trueparent ) {	  
+	  splitsides++;
+	  if(halomode != 1 && halomode != 2) parent = 0;
 	}
-	/* For now we skip this since orphan nodes are no longer needed to save
-	   because Dirichlet conditions are communicated in ElmerSolver. 	
-	   else if( halomode == 1 || halomode == 2 ) { */
-	else if( halomode == 2 ) {
-	  /* Halo elements ensure that both parents exist even if they are not trueparents */
-	  if( bcneeded2 < nodesd1 ) continue;
-	  haloelem = TRUE;
-	  halobcs += 1;
-	} 
-	else if( halomode == 3 ) {
-	  closeparent = closeparent2 = FALSE;
-	  if( part <= subparts ) {
-	    if( parent ) 
-	      if( elempart[parent] <= subparts) 
-		closeparent = ( ABS( elempart[parent]-part) == 1 );
-	    if( parent2 ) 
-	      if( elempart[parent2] <= subparts ) 
-		closeparent2 = ( ABS( elempart[parent2]-part) == 1 );
-	  }
-	  if(!closeparent && !closeparent2) continue;
-	  haloelem = TRUE;
-	  halobcs += 1;
+	else if( parent2 && !trueparent2 ) {
+	  splitsides++;
+	  if(!halomode != 1 && halomode != 2) parent2 = 0;
 	}
-	else {
-	  continue;
+      }
+      /* For now we skip this since orphan nodes are no longer needed to save
+	 because Dirichlet conditions are communicated in ElmerSolver. 	
+	 else if( halomode == 1 || halomode == 2 ) { */
+      else if( halomode == 2 ) {
+	/* Halo elements ensure that both parents exist even if they are not trueparents */
+	if( bcneeded2 < nodesd1 ) continue;
+	haloelem = TRUE;
+	halobcs += 1;
+      } 
+      else if( halomode == 3 ) {
+	closeparent = closeparent2 = FALSE;
+	if( part <= subparts ) {
+	  if( parent ) 
+	    if( elempart[parent] <= subparts) 
+	      closeparent = ( ABS( elempart[parent]-part) == 1 );
+	  if( parent2 ) 
+	    if( elempart[parent2] <= subparts ) 
+	      closeparent2 = ( ABS( elempart[parent2]-part) == 1 );
 	}
+	if(!closeparent && !closeparent2) continue;
+	haloelem = TRUE;
+	halobcs += 1;
+      }
+      else {
+	continue;
+      }
 
-	   
-	if(bound[j].ediscont) 
-	  discont = bound[j].discont[i];
-
-	sumsides++;	
-	sidetypes[sideelemtype] += 1;
-	    
-	if( haloelem ) 
-	  fprintf(out,"%d/%d %d %d %d %d",
-		  sumsides,elempart[parent],bctype,parent,parent2,sideelemtype);	    
-	else if(trueparent)
-	  fprintf(out,"%d %d %d %d %d",
-		  sumsides,bctype,parent,parent2,sideelemtype);	  
-	else
-	  fprintf(out,"%d %d %d %d %d",
-		  sumsides,bctype,parent2,parent,sideelemtype);	  
+      sumsides++;	
+      sidetypes[sideelemtype] += 1;
 	    
-	if(reorder) {
-	  for(l=0;l<nodesd1;l++)
-	    fprintf(out," %d",order[sideind[l]]);
-	} else {
-	  for(l=0;l<nodesd1;l++)
-	    fprintf(out," %d",sideind[l]);	  
-	}
-	fprintf(out,"\n");
+      if( haloelem ) 
+	fprintf(out,"%d/%d %d %d %d %d",
+		sumsides,elempart[parent],bctype,parent,parent2,sideelemtype);	    
+      else if(trueparent)
+	fprintf(out,"%d %d %d %d %d",
+		sumsides,bctype,parent,parent2,sideelemtype);	  
+      else
+	fprintf(out,"%d %d %d %d %d",
+		sumsides,bctype,parent2,parent,sideelemtype);	  
 	    
-	bcelemsaved[i] = TRUE;
-
-	/* Memorize that the node has already been saved as a regular BC. */
-	for(l=0;l<nodesd1;l++) {
-	  k = sideind[l];
-	  found = FALSE;
-	  for(l2=1;l2<=maxbcnodesaved;l2++) {
-	    if(bcnodesaved[l2][bcnode[k]] == bctype ) {
-	      found = TRUE;
-	      break;
-	    }
-	    if(bcnodesaved[l2][bcnode[k]] == 0 ) {
-	      bcnodesaved[l2][bcnode[k]] = bctype;
-	      found = TRUE;
-	      break;
-	    }
-	  }
-	  if( !found ) {
-	    maxbcnodesaved += 1;
-	    if(0) printf("Increasing size of bc owners to %d\n",maxbcnodesaved);
-	    bcnodesaved[maxbcnodesaved] = Ivector(1,nobcnodes);
-	    for(l3=1;l3<=nobcnodes;l3++)
-	      bcnodesaved[maxbcnodesaved][l3] = 0;
-	    bcnodesaved[maxbcnodesaved][bcnode[k]] = bctype;
-	    if(0) for(l3=1;l3<=maxbcnodesaved;l3++)
-		    printf("bc index: %d %d %d %d\n",l3,k,bcnode[k],bcnodesaved[l3][bcnode[k]]);
-	  }
-
-	}
+      if(reorder) {
+	for(l=0;l<nodesd1;l++)
+	  fprintf(out," %d",order[sideind[l]]);
+      } else {
+	for(l=0;l<nodesd1;l++)
+	  fprintf(out," %d",sideind[l]);	  
       }
+      fprintf(out,"\n");
     }
 
     /* The discontinuous stuff is more or less obsolite as these things can now be made also 
        within ElmerSolver. */
     /* The second side for discontinuous boundary conditions.
        Note that this has not been treated for orphan control. */
-    for(j=0;j < MAXBOUNDARIES;j++) {
-      for(i=1; i <= bound[j].nosides; i++) {
-	if(bound[j].ediscont) 
-	  discont = bound[j].discont[i];
-	else 
-	  discont = FALSE;
-	
-	if(!bound[j].parent2[i] || !discont) continue;
-	
-	GetElementSide(bound[j].parent2[i],bound[j].side2[i],-bound[j].normal[i],
-		       data,sideind,&sideelemtype); 
-	nodesd1 = sideelemtype%100;	
-	
-	bcneeded = 0;
-	for(l=0;l<nodesd1;l++) {
-	  ind = sideind[l];
-	  for(k=1;k<=neededtimes[ind];k++)
-	    if(part == data->partitiontable[k][ind]) bcneeded++;
-	}
-	if(bcneeded < nodesd1) continue;
+    for(bc=discstart[part];bc<discstart[part+1];bc++) {
+      j = discboundary[bc];
+      i = discside[bc];
 	
+      GetElementSide(bound[j].parent2[i],bound[j].side2[i],-bound[j].normal[i],
+		     data,sideind,&sideelemtype); 
+      nodesd1 = sideelemtype%100;	
 	
-	trueparent = (elempart[bound[j].parent2[i]] == part);
-	if(!trueparent) continue;
+      bcneeded = 0;
+      for(l=0;l<nodesd1;l++) {
+	ind = sideind[l];
+	for(k=1;k<=neededtimes[ind];k++)
+	  if(part == data->partitiontable[k][ind]) bcneeded++;
+      }
+      if(bcneeded < nodesd1) continue;
 	
-	sumsides++;
-	fprintf(out,"%d %d %d %d ",
-		sumsides,bound[j].types[i],bound[j].parent2[i],bound[j].parent[i]);
+      sumsides++;
+      fprintf(out,"%d %d %d %d ",
+	      sumsides,bound[j].types[i],bound[j].parent2[i],bound[j].parent[i]);
 	
-	fprintf(out,"%d ",sideelemtype);
-	sidetypes[sideelemtype] += 1;
-	if(reorder) {
-	  for(l=0;l<nodesd1;l++)
-	    fprintf(out,"%d ",order[sideind[l]]);
-	} 
-	else {
-	  for(l=0;l<nodesd1;l++)
-	    fprintf(out,"%d ",sideind[l]);	  
-	} 
-	fprintf(out,"\n");
-      }
+      fprintf(out,"%d ",sideelemtype);
+      sidetypes[sideelemtype] += 1;
+      if(reorder) {
+	for(l=0;l<nodesd1;l++)
+	  fprintf(out,"%d ",order[sideind[l]]);
+      } 
+      else {
+	for(l=0;l<nodesd1;l++)
+	  fprintf(out,"%d ",sideind[l]);	  
+      } 
+      fprintf(out,"\n");
     }
     sidesinpart[part] = sumsides;
         
@@ -5934,92 +6488,81 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
        This makes it possible for ElmerSolver to create a matrix connection that 
        is known to exist. */
 
-    if (indirect) {
-      int maxsides,nodesides,maxnodeconnections,connectednodes,m;
-      int **nodepairs=NULL,*nodeconnections,**indpairs;      
-
-      nodeconnections = bcnodedummy;
-      l = 0;
-      maxsides = 0;
-      nodesides = 0;
-
-  findindirect:
+    if (indirect && indstart[part+1] > indstart[part]) {
+      int maxsides,nodesides,maxnodeconnections,connectednodes,m,e;
+      int **nodepairs=NULL,**indpairs;      
 
       /* First calculate the maximum number of additional sides */
-      for(i=1;i<=noelements;i++) {
+      maxsides = 0;
+      for(e=indstart[part];e<indstart[part+1];e++) {
+	i = indelems[e];
+	nodesd2 = data->elementtypes[i]%100;
+	bcneeded = 0;
+	for(j=0;j < nodesd2;j++) {
+	  ind = data->topology[i][j];
+	  for(k=1;k<=neededtimes[ind];k++) 
+	    if(part == data->partitiontable[k][ind]) {
+	      bcneeded++;
+	      break;
+	    }
+	}
+	maxsides += (bcneeded-1)*bcneeded/2;
+      }
 
-	/* owner partition cannot cause an indirect coupling */
-	if(elempart[i] == part) continue;
-	
-	elemtype = data->elementtypes[i];
-	nodesd2 = elemtype%100;
+      /* Then memorize all indirect non-element couplings. */      
+      nodepairs = Imatrix(1,maxsides,1,2);
+      nodesides = 0;
+      for(e=indstart[part];e<indstart[part+1];e++) {
+	i = indelems[e];
+	nodesd2 = data->elementtypes[i]%100;
 	
-	/* Check how many nodes still belong to this partition, 
-	   if more than one there may be indirect coupling. */
 	for(j=0;j < nodesd2;j++) {
 	  elemhit[j] = FALSE;
 	  ind = data->topology[i][j];
 	  for(k=1;k<=neededtimes[ind];k++) 
 	    if(part == data->partitiontable[k][ind]) elemhit[j] = TRUE;
 	}
-	bcneeded = 0;
-	for(j=0;j < nodesd2;j++) 
-	  if(elemhit[j]) bcneeded++;
-	if(bcneeded <= 1) continue;
-	
-	if(l == 0) {
-	  maxsides += (bcneeded-1)*bcneeded/2;
-	} 
-	else {
-	  for(j=0;j < nodesd2;j++) {	  
-	    for(k=j+1;k < nodesd2;k++) {
-	      if(elemhit[j] && elemhit[k]) {
-		nodesides += 1;
-
-		/* The minimum index always first */
-		if(data->topology[i][j] <= data->topology[i][k]) {
-		  nodepairs[nodesides][1] = data->topology[i][j];
-		  nodepairs[nodesides][2] = data->topology[i][k];
-		}
-		else {
-		  nodepairs[nodesides][1] = data->topology[i][k];
-		  nodepairs[nodesides][2] = data->topology[i][j];		  
-		}
+	for(j=0;j < nodesd2;j++) {	  
+	  for(k=j+1;k < nodesd2;k++) {
+	    if(elemhit[j] && elemhit[k]) {
+	      nodesides += 1;
+
+	      /* The minimum index always first */
+	      if(data->topology[i][j] <= data->topology[i][k]) {
+		nodepairs[nodesides][1] = data->topology[i][j];
+		nodepairs[nodesides][2] = data->topology[i][k];
+	      }
+	      else {
+		nodepairs[nodesides][1] = data->topology[i][k];
+		nodepairs[nodesides][2] = data->topology[i][j];		  
 	      }
 	    }
 	  }
 	}
       }
-
-      /* After first round allocate enough space to memorize all indirect non-element couplings. */      
-      if(l == 0) {
-	nodepairs = Imatrix(1,maxsides,1,2);
-	for(i=1;i<=maxsides;i++)
-	  nodepairs[i][1] = nodepairs[i][2] = 0;
-	l++;
-	goto findindirect;
-      }
       if(0) printf("Number of non-element connections is %d\n",nodesides);
       
-      
-      for(i=1;i<=noknots;i++)
-	nodeconnections[i] = 0;
-      
-      for(i=1;i<=nodesides;i++)
-	nodeconnections[nodepairs[i][1]] += 1;
-      
-      maxnodeconnections = 0;
-      for(i=1;i<=noknots;i++)
-	maxnodeconnections = MAX(maxnodeconnections, nodeconnections[i]);     
-      if(0) printf("Maximum number of node-to-node connections %d\n",maxnodeconnections);
-
+      /* Number the nodes with connections compactly. The nodes are kept in a sorted 
+	 list of this partition only, so that no table over all nodes is needed. */
+      connnodes = Ivector(1,MAX(nodesides,1));
+      conncount = Ivector(1,MAX(nodesides,1));
+      for(i=1;i<=nodesides;i++) 
+	connnodes[i] = nodepairs[i][1];
+      if(nodesides > 1) qsort(&connnodes[1],(size_t) nodesides,sizeof(int),CompareInts);
       connectednodes = 0;
-      for(i=1;i<=noknots;i++) {
-	if(nodeconnections[i] > 0) {
-	  connectednodes++;
-	  nodeconnections[i] = connectednodes;
-	}
+      for(i=1;i<=nodesides;i++) {
+	if(connectednodes && connnodes[connectednodes] == connnodes[i]) continue;
+	connectednodes++;
+	connnodes[connectednodes] = connnodes[i];
       }
+      for(i=1;i<=connectednodes;i++) 
+	conncount[i] = 0;
+      for(i=1;i<=nodesides;i++) 
+	conncount[ConnectedNodeIndex(nodepairs[i][1],connnodes,connectednodes)] += 1;
+      maxnodeconnections = 0;
+      for(i=1;i<=connectednodes;i++)
+	maxnodeconnections = MAX(maxnodeconnections, conncount[i]);     
+      if(0) printf("Maximum number of node-to-node connections %d\n",maxnodeconnections);
       if(0) printf("Number of nodes with non-element connections %d\n",connectednodes);
 
       indpairs = Imatrix(1,connectednodes,1,maxnodeconnections);
@@ -6028,7 +6571,7 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
 	  indpairs[i][j] = 0;
       
       for(i=1;i<=nodesides;i++) {
-	ind = nodeconnections[nodepairs[i][1]];
+	ind = ConnectedNodeIndex(nodepairs[i][1],connnodes,connectednodes);
 	for(j=1;j<=maxnodeconnections;j++) {
 	  if(indpairs[ind][j] == 0) {
 	    indpairs[ind][j] = i;	    
@@ -6059,14 +6602,14 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
       
       /* Remove connections that already exist */
       m = 0;
-      for(i=1;i<=noelements;i++) {
-	if(elempart[i] != part) continue;
+      for(e=ownstart[part];e<ownstart[part+1];e++) {
+	i = ownelems[e];
 	
 	elemtype = data->elementtypes[i];
 	nodesd2 = elemtype%100;
 	
 	for(j=0;j < nodesd2;j++) {
-	  ind = nodeconnections[data->topology[i][j]];
+	  ind = ConnectedNodeIndex(data->topology[i][j],connnodes,connectednodes);
 	  if(!ind) continue;
 	  
 	  for(k=0;k < nodesd2;k++) {
@@ -6105,6 +6648,8 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
       }
 
       /* Finally free some extra space that was allocated */
+      free_Ivector(connnodes,1,MAX(nodesides,1));
+      free_Ivector(conncount,1,MAX(nodesides,1));
       free_Imatrix(indpairs,1,connectednodes,1,maxnodeconnections);
       free_Imatrix(nodepairs,1,maxsides,1,2);
     }
@@ -6124,8 +6669,16 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
       if(sidetypes[i]) tottypes++;
     }
 
+    sprintf(filename,"%s.%d.%s","part",part,"bin");
+    remove(filename);
+
     sprintf(filename,"%s.%d.%s","part",part,"header");
     out = fopen(filename,"w");
+    if(out == NULL) {
+      printf("Could not open file for writing: %s\n",filename);
+      openfail++;
+      continue;
+    }
     fprintf(out,"%-6d %-6d %-6d\n",
 	    needednodes[part],elementsinpart[part],sumsides);  
 
@@ -6140,16 +6693,26 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
 
     fprintf(out,"%-6d %-6d\n",neededtwice[part],0);
     fclose(out);
+  }
 
-    if(info) {
-      if(part == 1) {
-	printf("   %-5s %-10s %-10s %-8s %-8s %-8s\n",
-	       "part","elements","nodes","shared","bc elems","indirect");
-      }
+    free_Ivector(sidetypes,minelemtype,maxelemtype);
+  }
+  /* end of omp parallel */
+
+  if(openfail) {
+    printf("Could not write %d partition files, writing is cancelled!\n",openfail);
+    cdstat = chdir("..");
+    cdstat = chdir("..");
+    return(1);
+  }
+
+  if(info) {
+    printf("   %-5s %-10s %-10s %-8s %-8s %-8s\n",
+	   "part","elements","nodes","shared","bc elems","indirect");
+    for(part=1;part<=partitions;part++) 
       printf("   %-5d %-10d %-10d %-8d %-8d %-8d\n",
 	     part,elementsinpart[part],ownnodes[part],sharednodes[part],sidesinpart[part],
 	     indirectinpart[part]);
-    }
   }
   /*********** end of part.n.header *********************/
 
@@ -6186,6 +6749,19 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
   for(i=1;i<=maxbcnodesaved;i++)
     free_Ivector(bcnodesaved[i],1,nobcnodes);
   if(halomode) free_Ivector(neededtimes2,1,noknots);
+  free_Ivector(bcboundary,0,MAX(bcstart[partitions+1],1));
+  free_Ivector(bcside,0,MAX(bcstart[partitions+1],1));
+  free_Ivector(bcstart,1,partitions+1);
+  free_Ivector(discboundary,0,MAX(nodiscsides,1));
+  free_Ivector(discside,0,MAX(nodiscsides,1));
+  free_Ivector(discstart,1,partitions+1);
+  if(indirect) {
+    free_Ivector(ownelems,0,MAX(ownstart[partitions+1],1));
+    free_Ivector(indelems,0,MAX(indstart[partitions+1],1));
+    free_Ivector(ownstart,1,partitions+1);
+    free_Ivector(indstart,1,partitions+1);
+  }
+  free(outfiles);
   
   
   cdstat = chdir("..");
@@ -6196,7 +6772,6 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
   free_Ivector(neededtwice,1,partitions);
   free_Ivector(sharednodes,1,partitions);
   free_Ivector(ownnodes,1,partitions);
-  free_Ivector(sidetypes,minelemtype,maxelemtype);
   free_Imatrix(bulktypes,1,partitions,minelemtype,maxelemtype);
   
   if(info) printf("Writing of partitioned mesh finished\n");
@@ -6209,9 +6784,10 @@ int SaveElmerInputPartitioned(struct FemType *data,struct BoundaryType *bound,
 int ReorderElementsMetis(struct FemType *data,int info)
 /* Calls the fill reduction ordering algorithm of Metis library. */
 {
-  int i,j,k,nn,totcon,maxcon,con,options[8];
+  int i,j,k,nn,totcon;
   int noelements,noknots,nonodes;
-  int *xadj,*adjncy,numflag,*iperm=NULL,*perm=NULL,**newtopology;
+  int *xadj,*adjncy,*iperm=NULL,*perm=NULL,**newtopology;
+  idx_t options[METIS_NOPTIONS];
   Real *newx,*newy,*newz = NULL;
 
   noelements = data->noelements;
@@ -6225,47 +6801,27 @@ int ReorderElementsMetis(struct FemType *data,int info)
 
 
   CreateNodalGraph(data,TRUE,info);
-  maxcon = data->nodalmaxconnections;
 
-  totcon = 0;
-  for(i=1;i<=noknots;i++) {
-    for(j=0;j<maxcon;j++) {
-      con = data->nodalgraph[j][i];
-      if(con) totcon++;
-    }
-  }
+  /* The nodal graph is already in the sparse matrix format used by Metis */
+  xadj = data->nodalgraph.rows;
+  adjncy = data->nodalgraph.cols;
+  totcon = xadj[noknots];
   if(info) printf("There are %d connections alltogether\n",totcon);
 
-  xadj = Ivector(0,noknots);
-  adjncy = Ivector(0,totcon-1);
-  for(i=0;i<totcon;i++) 
-    adjncy[i] = 0;
-
-  totcon = 0;
-  for(i=1;i<=noknots;i++) {
-    xadj[i-1] = totcon;
-    for(j=0;j<maxcon;j++) {
-      con = data->nodalgraph[j][i];
-      if(con) {
-	adjncy[totcon] = con-1;
-	totcon++;
-      }
-    }
-  }
-  xadj[noknots] = totcon;
-
   nn = noknots;
-  numflag = 0;
-  for(i=0;i<8;i++) options[i] = 0;
+  METIS_SetDefaultOptions(options);
+  options[METIS_OPTION_NUMBERING] = 0; 
   perm = Ivector(0,noknots-1);
   iperm = Ivector(0,noknots-1);
   
   if(info) printf("Starting Metis reordering routine.\n");
 
-  METIS_NodeND(&nn,xadj,adjncy,&numflag,&options[0],perm,iperm);
+  METIS_NodeND(&nn,xadj,adjncy,NULL,options,perm,iperm);
 
   if(info) printf("Finished Metis reordering routine.\n");
 
+  DestroyNodalGraph(data,info);
+
   if(info) printf("Moving knots to new positions\n");
   newx = Rvector(1,data->noknots);
   newy = Rvector(1,data->noknots);
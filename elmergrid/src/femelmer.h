@@ -13,6 +13,8 @@ int SaveSolutionElmer(struct FemType *data,struct BoundaryType *bound,
 int SaveSolutionElmerTriangles(struct FemType *data,char *prefix,int info);
 int SaveElmerInput(struct FemType *data,struct BoundaryType *bound,
 		   char *prefix,int decimals,int nooverwrite, int info);
+int SaveElmerInputBinary(char *prefix,int info);
+int SaveElmerInputBinaryPartitioned(char *prefix,int partitions,int info);
 int SaveSizeInfo(struct FemType *data,struct BoundaryType *bound,
 		 char *prefix,int info);
 int SaveElmerInputFemBem(struct FemType *data,struct BoundaryType *bound,
@@ -42,6 +42,16 @@
 #include "femknot.h"
 #include "femfilein.h"
 
+#if !defined(MINGW32) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #define GETLINE getlineptr=fgets(line,MAXLINESIZE,in) 
 #define GETLONGLINE getlineptr=fgets(longline,LONGLINESIZE,in)
 
@@ -80,7 +90,7 @@ static int Getrow(char *line1,FILE *io,int upper)
   return(0);
 }
 
-static int GetrowDouble(char *line1,FILE *io)
+static int Comsolrow(char *line1,FILE *io) 
 {
   int i,isend;
   char line0[MAXLINESIZE],*charend;
@@ -88,7 +98,6 @@ static int GetrowDouble(char *line1,FILE *io)
   for(i=0;i<MAXLINESIZE;i++) 
     line0[i] = ' ';
 
- newline:
   charend = fgets(line0,MAXLINESIZE,io);
   linenumber += 1;
 
@@ -96,39 +105,326 @@ static int GetrowDouble(char *line1,FILE *io)
 
   if(isend) return(1);
 
-  if(line0[0] == '#' || line0[0] == '!') goto newline;
-  if(strstr(line0,"#")) goto newline;
+  for(i=0;i<MAXLINESIZE;i++) line1[i] = line0[i];    
 
-  for(i=0;i<MAXLINESIZE;i++) { 
+  return(0);
+}
 
-    /* The fortran double is not recognized by C string operators */
-    if( line0[i] == 'd' || line0[i] == 'D' ) {
-      line1[i] = 'e';
-    } else {
-      line1[i] = line0[i];    
+
+
+/* Readers for large files. The file is mapped to memory (or read into it in 
+   chunks where mapping is not available) and the data sections are indexed 
+   into lines in windows of some tens of megabytes. The lines of a window are 
+   independent of each other and are parsed in parallel. */
+
+#define LINEWINDOWSIZE 67108864
+
+struct MappedFile {
+  char *buf;
+  size_t size;
+  int mapped;
+};
+
+struct LineWindow {
+  const char *end;     /* end of the data that may be indexed */
+  const char **line;   /* starts of the lines, line[n] is the end of the last one */
+  long n,i,maxn;       /* indexed lines, the next unused one and the allocated size */
+};
+
+
+static int MapFile(const char *filename,struct MappedFile *mf)
+{
+  FILE *in;
+  size_t n,maxsize;
+  char *buf;
+
+  mf->buf = NULL;
+  mf->size = 0;
+  mf->mapped = FALSE;
+
+#if !defined(MINGW32) && !defined(_WIN32)
+  {
+    struct stat st;
+    int fd;
+    
+    fd = open(filename,O_RDONLY);
+    if(fd < 0) return(1);
+
+    /* The parsers need the data to be followed by a zero which the mapping 
+       gives for free unless the file ends exactly at a page boundary. */
+    if(fstat(fd,&st) == 0 && st.st_size > 0 && st.st_size % sysconf(_SC_PAGESIZE)) {
+      buf = mmap(NULL,(size_t) st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+      if(buf != MAP_FAILED) {
+	madvise(buf,(size_t) st.st_size,MADV_SEQUENTIAL);
+	mf->buf = buf;
+	mf->size = st.st_size;
+	mf->mapped = TRUE;
+      }
     }
+    close(fd);
+    if(mf->mapped) return(0);
+  }
+#endif
+
+  if ((in = fopen(filename,"rb")) == NULL) return(1);
+
+  maxsize = 0;
+  buf = NULL;
+  for(;;) {
+    if(mf->size + LINEWINDOWSIZE + 1 > maxsize) {
+      maxsize = 2*maxsize + LINEWINDOWSIZE + 1;
+      buf = realloc(mf->buf,maxsize);
+      if(!buf) nrerror("allocation failure in MapFile()");
+      mf->buf = buf;
+    }
+    n = fread(mf->buf+mf->size,1,LINEWINDOWSIZE,in);
+    mf->size += n;
+    if(n < LINEWINDOWSIZE) break;
   }
+  fclose(in);
+  mf->buf[mf->size] = '\0';
 
   return(0);
 }
 
 
-static int Comsolrow(char *line1,FILE *io) 
+static void UnmapFile(struct MappedFile *mf)
 {
-  int i,isend;
-  char line0[MAXLINESIZE],*charend;
+#if !defined(MINGW32) && !defined(_WIN32)
+  if(mf->mapped) 
+    munmap(mf->buf,mf->size);
+  else
+#endif
+    free(mf->buf);
+  mf->buf = NULL;
+  mf->size = 0;
+}
 
-  for(i=0;i<MAXLINESIZE;i++) 
-    line0[i] = ' ';
 
-  charend = fgets(line0,MAXLINESIZE,io);
-  linenumber += 1;
+static void InitLineWindow(struct LineWindow *lw,const char *pos,const char *end)
+{
+  lw->end = end;
+  lw->maxn = 1024;
+  lw->line = (const char**) malloc(lw->maxn*sizeof(const char*));
+  if(!lw->line) nrerror("allocation failure in InitLineWindow()");
+  lw->line[0] = pos;
+  lw->n = lw->i = 0;
+}
 
-  isend = (charend == NULL);
 
-  if(isend) return(1);
+static void FreeLineWindow(struct LineWindow *lw)
+{
+  free(lw->line);
+  lw->line = NULL;
+}
 
-  for(i=0;i<MAXLINESIZE;i++) line1[i] = line0[i];    
+
+static const char *LineWindowPosition(struct LineWindow *lw)
+/* The start of the first line that has not been taken */
+{
+  return(lw->line[lw->i]);
+}
+
+
+static void FillLineWindow(struct LineWindow *lw)
+/* Index the lines of the next window starting from the first unused line. 
+   The window is split in fixed chunks whose newlines are first counted and 
+   then registered, so the result does not depend on the number of threads. */
+{
+  const char *start,*wend;
+  long *counts,nlines,k;
+  int nc,c;
+
+  start = lw->line[lw->i];
+  wend = start + MIN((size_t) (lw->end - start),(size_t) LINEWINDOWSIZE);
+  while(wend < lw->end && wend[-1] != '\n') wend++;
+
+  nc = 1;
+#ifdef _OPENMP
+  nc = 4*omp_get_max_threads();
+#endif
+  counts = (long*) malloc((nc+1)*sizeof(long));
+  counts[0] = 0;
+  
+#pragma omp parallel for schedule(static)
+  for(c=0;c<nc;c++) {
+    const char *a,*b,*p;
+    long n;
+
+    a = start + (wend-start)*c/nc;
+    b = start + (wend-start)*(c+1)/nc;
+    n = 0;
+    for(p=a;p<b && (p = memchr(p,'\n',b-p));p++) n++;
+    counts[c+1] = n;
+  }
+
+  for(k=1;k<=nc;k++) counts[k] += counts[k-1];
+  if(counts[nc]+2 > lw->maxn) {
+    free(lw->line);
+    lw->maxn = counts[nc]+2;
+    lw->line = (const char**) malloc(lw->maxn*sizeof(const char*));
+    if(!lw->line) nrerror("allocation failure in FillLineWindow()");
+  }
+
+#pragma omp parallel for schedule(static)
+  for(c=0;c<nc;c++) {
+    const char *a,*b,*p;
+    long n;
+
+    a = start + (wend-start)*c/nc;
+    b = start + (wend-start)*(c+1)/nc;
+    n = counts[c];
+    for(p=a;p<b && (p = memchr(p,'\n',b-p));p++) 
+      lw->line[++n] = p+1;
+  }
+
+  nlines = counts[nc];
+  lw->line[0] = start;
+  if(wend > start && wend[-1] != '\n') 
+    lw->line[++nlines] = wend;
+  lw->n = nlines;
+  lw->i = 0;
+  
+  free(counts);
+}
+
+
+static long TakeLines(struct LineWindow *lw,long minlines,long maxlines,const char ***lines)
+/* Take consecutive lines from the window. The window is refilled, keeping 
+   the unused lines, if there are less than minlines of them left. */
+{
+  long m;
+
+  if(lw->n - lw->i < minlines && lw->line[lw->n] < lw->end) 
+    FillLineWindow(lw);
+
+  m = MIN(maxlines,lw->n - lw->i);
+  *lines = lw->line + lw->i;
+  lw->i += m;
+  return(m);
+}
+
+
+static void UntakeLines(struct LineWindow *lw,long m)
+{
+  lw->i -= m;
+}
+
+
+static const char *SkipBlanks(const char *cp)
+{
+  while(*cp == ' ' || *cp == '\t' || *cp == '\r') cp++;
+  return(cp);
+}
+
+
+static int ParseInt(const char **cp)
+/* Like next_int but does not continue to the next line */
+{
+  const char *p;
+  int neg;
+  long long i;
+
+  p = SkipBlanks(*cp);
+  neg = (*p == '-');
+  if(*p == '-' || *p == '+') p++;
+  for(i=0;*p >= '0' && *p <= '9';p++) 
+    i = 10*i + (*p-'0');
+  *cp = p;
+  return((int) (neg ? -i : i));
+}
+
+
+static Real ParseReal(const char **cp)
+/* Like next_real, also recognizing the fortran exponent D. Numbers with at most 
+   19 significant digits and a moderate exponent are parsed exactly with one 
+   floating point operation, the others go through strtod. Tokens that are not 
+   plain decimal numbers, such as nan, inf or hexadecimal ones, are given to 
+   strtod as they are. */
+{
+  static const double pow10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+				 1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+  const char *p,*p0;
+  char buf[64],*end;
+  unsigned long long m;
+  int neg,nd,e,ee,eneg,i,digits;
+  Real r;
+
+  p0 = p = SkipBlanks(*cp);
+  neg = (*p == '-');
+  if(*p == '-' || *p == '+') p++;
+
+  m = 0;
+  nd = 0;
+  e = 0;
+  digits = isdigit((unsigned char) p[0]) || (p[0] == '.' && isdigit((unsigned char) p[1]));
+  while(*p == '0') p++;
+  for(;*p >= '0' && *p <= '9';p++,nd++) 
+    m = 10*m + (*p-'0');
+  if(*p == '.') {
+    p++;
+    if(!m) for(;*p == '0';p++) e--;
+    for(;*p >= '0' && *p <= '9';p++,nd++,e--) 
+      m = 10*m + (*p-'0');
+  }
+  if(!digits || (isalpha((unsigned char) *p) && !strchr("eEdD",*p))) {
+    for(i=0;i < 63 && p0[i] && !isspace((unsigned char) p0[i]) && p0[i] != ',';i++) 
+      buf[i] = p0[i];
+    buf[i] = '\0';
+    r = strtod(buf,&end);
+    *cp = p0 + (end-buf);
+    return(end > buf ? r : 0.0);
+  }
+  if(*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D') {
+    const char *q = p+1;
+    eneg = (*q == '-');
+    if(*q == '-' || *q == '+') q++;
+    if(*q >= '0' && *q <= '9') {
+      for(ee=0;*q >= '0' && *q <= '9';q++) 
+	if(ee < 10000) ee = 10*ee + (*q-'0');
+      e += eneg ? -ee : ee;
+      p = q;
+    }
+  }
+
+  if(nd <= 19 && m < (1ULL << 53) && e >= -22 && e <= 22) {
+    r = (Real) m;
+    if(e < 0) 
+      r /= pow10[-e];
+    else 
+      r *= pow10[e];
+    *cp = p;
+    return(neg ? -r : r);
+  }
+
+  for(i=0;p0+i < p && i < 63;i++) 
+    buf[i] = (p0[i] == 'd' || p0[i] == 'D') ? 'e' : p0[i];
+  buf[i] = '\0';
+  r = strtod(buf,&end);
+  *cp = p;
+  return(r);
+}
+
+
+static int WindowGetrow(char *line1,struct LineWindow *lw)
+/* As Getrow but reading from a line window */
+{
+  const char **lines,*p;
+  long m;
+  int i;
+
+ newline:
+  m = TakeLines(lw,1,1,&lines);
+  if(!m) return(1);
+  linenumber += 1;
+
+  p = lines[0];
+  if(p[0] == '#' || p[0] == '!') goto newline;
+  for(i=0;p+i < lines[1] && i < MAXLINESIZE-1;i++) {
+    if(p[i] == '#') goto newline;
+    line1[i] = p[i];
+  }
+  line1[i] = '\0';
 
   return(0);
 }
@@ -3703,404 +3999,547 @@ omstart:
 }
 
 
+static const char *GmshNextLine(const char *p,const char *end)
+{
+  p = memchr(p,'\n',end-p);
+  return(p ? p+1 : end);
+}
+
+
+static const char *GmshSectionEnd(const char *p,const char *end,const char *name)
+/* Find the line following the end tag of a section, e.g. $EndNodes */
+{
+  size_t len;
+  
+  len = strlen(name);
+  for(;p < end && (p = memchr(p,'$',end-p));p++) {
+    if(end-p > len+4 && !strncmp(p+1,"End",3) && !strncmp(p+4,name,len)) 
+      return(GmshNextLine(p,end));
+  }
+  return(end);
+}
+
+
+static long long GmshBinarySize(const char **p,int datasize)
+{
+  long long i;
+
+  if(datasize == 8) {
+    unsigned long long u;
+    memcpy(&u,*p,8);
+    i = u;
+  }
+  else {
+    unsigned int u;
+    memcpy(&u,*p,4);
+    i = u;
+  }
+  *p += datasize;
+  return(i);
+}
+
+
+static int GmshBinaryInt(const char **p)
+{
+  int i;
+
+  memcpy(&i,*p,sizeof(int));
+  *p += sizeof(int);
+  return(i);
+}
+
+
+static Real GmshBinaryReal(const char *p)
+{
+  double r;
+
+  memcpy(&r,p,sizeof(double));
+  return(r);
+}
+
+
 static int LoadGmshInput4(struct FemType *data,struct BoundaryType *bound,
 			  char *filename,int info)
+/* Gmsh format 4, ASCII versions 4.0 and 4.1 and binary version 4.1. The file 
+   is mapped to memory and read in one sweep, except for the element block 
+   headers that are first walked through to know the size of the topology. 
+   The lines, or records, of the node and element blocks are parsed in parallel. */
 {
-  int noknots = 0,noelements = 0,nophysical = 0,maxnodes,dim,notags;
-  int elemind[MAXNODESD2],elementtype;
-  int i,j,k,l,allocated,*revindx=NULL,maxindx;
-  int elemno, gmshtype, tagphys=0, taggeom=0, tagpart, elemnodes,maxelemtype;
-  int tagmat,verno;
-  int physvolexist, physsurfexist,**tagmap,tagsize;
-  FILE *in;
+  int noknots = 0,noelements = 0,nophysical = 0,maxnodes,dim;
+  int elementtype,binary,datasize,minor,numblocks;
+  int i,j,k,maxindx,renumber,*nodetag=NULL,*revindx=NULL;
+  int gmshtype, tagphys=0;
+  int physvolexist, physsurfexist,**tagmap=NULL,tagsize;
+  int *blockdim=NULL,*blocktag=NULL,*blocktype=NULL,*blocksize=NULL;
+  struct MappedFile mf;
+  struct LineWindow lw;
+  const char **lines,*cp,*end,*cp0;
   const char manifoldname[4][10] = {"point", "line", "surface", "volume"};
-  char *cp,line[MAXLINESIZE],longline[LONGLINESIZE];
+  char line[MAXLINESIZE],*lp;
+  Real version;
 
-  if ((in = fopen(filename,"r")) == NULL) {
+  if(MapFile(filename,&mf)) {
     printf("LoadGmshInput4: The opening of the mesh file %s failed!\n",filename);
     return(1);
   }
-  if(info) printf("Loading mesh in Gmsh format 4.0 from file %s\n",filename);
 
-  allocated = FALSE;
   dim = data->dim;
+  InitializeKnots(data);
+  data->dim = dim;
+
   maxnodes = 0;
-  maxindx = 0;
-  maxelemtype = 0;
+  tagsize = 0;
   physvolexist = FALSE;
   physsurfexist = FALSE;
+  binary = FALSE;
+  datasize = 8;
+  minor = 0;
 
-omstart:
+  cp = mf.buf;
+  end = mf.buf + mf.size;
 
   for(;;) {
-    if(Getrow(line,in,FALSE)) goto end;
-    if(strstr(line,"$End")) continue;
- 
-    if(strstr(line,"$MeshFormat")) {
-      GETLINE;
-      cp = line;
-      verno = next_int(&cp);
-
-      if(verno != 4) {
-	printf("Version number is not compatible with the parser: %d\n",verno);
+    while(cp < end && isspace((unsigned char) *cp)) cp++;
+    if(cp >= end || *cp == '\0') break;
+
+    if(!strncmp(cp,"$MeshFormat",11)) {
+      cp = GmshNextLine(cp,end);
+      version = ParseReal(&cp);
+      binary = ParseInt(&cp);
+      datasize = ParseInt(&cp);
+      minor = (int) (10.0*(version-4.0)+0.5);
+      cp = GmshNextLine(cp,end);
+
+      if((int) version != 4) 
+	printf("Version number is not compatible with the parser: %.1lf\n",version);
+      if(info) printf("Loading mesh in Gmsh %s format %.1lf from file %s\n",
+		      binary ? "binary" : "ASCII",version,filename);
+
+      if(binary) {
+	if(minor < 1) 
+	  printf("LoadGmshInput4: Only binary Gmsh files of version 4.1 are supported!\n");
+	else if(datasize != 4 && datasize != 8) 
+	  printf("LoadGmshInput4: Unsupported data size %d in binary file!\n",datasize);
+	else if(GmshBinaryInt(&cp) != 1) 
+	  printf("LoadGmshInput4: Byte order of the binary file differs from this machine!\n");
+	else
+	  binary = 2;
+	if(binary != 2) {
+	  UnmapFile(&mf);
+	  return(1);
+	}
       }
+      cp = GmshSectionEnd(cp,end,"MeshFormat");
+    }
 
-      GETLINE;
-      if(!strstr(line,"$EndMeshFormat")) {
-	printf("$MeshFormat section should end to string $EndMeshFormat:\n%s\n",line);
-      }      
+    else if(!strncmp(cp,"$PhysicalNames",14)) {
+      cp = GmshNextLine(cp,end);
+      nophysical = ParseInt(&cp);
+      cp = GmshNextLine(cp,end);
+
+      for(i=0;i<nophysical;i++) {
+	for(j=0;cp+j < end && cp[j] != '\n' && j < MAXLINESIZE-2;j++) 
+	  line[j] = cp[j];
+	line[j++] = '\n';
+	line[j] = '\0';
+	cp = GmshNextLine(cp,end);
+
+	lp = line;
+	gmshtype = next_int(&lp);
+	tagphys = next_int(&lp);
+	if(gmshtype == dim-1) {
+	  physsurfexist = TRUE;
+	  if(tagphys < MAXBCS) {
+	    sscanf(lp," \"%[^\"]\"",data->boundaryname[tagphys]);
+	    printf("Boundary name for physical group %d is: %s\n",tagphys,data->boundaryname[tagphys]);
+	  }
+	  else
+	    printf("Index %d too high: ignoring physical %s %s",tagphys,manifoldname[dim-1],lp+1);
+	}
+	else if(gmshtype == dim) {
+	  physvolexist = TRUE;
+	  if(tagphys < MAXBODIES) {
+	    sscanf(lp," \"%[^\"]\"",data->bodyname[tagphys]);
+	    printf("Body name for physical group %d is: %s\n",tagphys,data->bodyname[tagphys]);
+	  }
+	  else
+	    printf("Index %d too high: ignoring physical %s %s",tagphys,manifoldname[dim],lp+1);
+	}
+	else printf("Physical groups of dimension %d not supported in %d-dimensional mesh: "
+		    "ignoring group %d %s",gmshtype,dim,tagphys,lp+1);
+      }
+      cp = GmshSectionEnd(cp,end,"PhysicalNames");
     }
-      
-    else if(strstr(line,"$Nodes")) {
-      int numEntityBlocks,tagEntity,dimEntity,parEntity,numNodes,ind;
 
-      GETLINE;
-      cp = line;
+    else if(!strncmp(cp,"$Entities",9)) {
+      int numEnt[4],maxtag[4],tagdim,nophys,noent,*enttag,*entphys;
 
-      numEntityBlocks = next_int(&cp);
-      noknots = next_int(&cp);
+      cp = GmshNextLine(cp,end);
+      for(tagdim=0;tagdim<=3;tagdim++) 
+	numEnt[tagdim] = binary ? GmshBinarySize(&cp,datasize) : ParseInt(&cp);
+      if(!binary) cp = GmshNextLine(cp,end);
 
-      if(allocated && info) printf("Reading %d nodes in %d blocks.\n",noknots,numEntityBlocks);
-      
-      k = 0;
-      
-      for(j=1; j <= numEntityBlocks; j++) {
-	GETLINE;
-	cp = line;
+      noent = numEnt[0] + numEnt[1] + numEnt[2] + numEnt[3];
+      enttag = Ivector(0,noent);
+      entphys = Ivector(0,noent);
 
-	tagEntity = next_int(&cp);
-	dimEntity = next_int(&cp);
-	parEntity = next_int(&cp);
-	numNodes = next_int(&cp);
-	       	
-	for(i=1; i <= numNodes; i++) {
-	  GETLINE;
-	  cp = line;
-	  k += 1;
-	  
-	  ind = next_int(&cp);
-	  if(allocated) {
-	    if(maxindx > noknots) revindx[ind] = k;
-	    data->x[k] = next_real(&cp);
-	    data->y[k] = next_real(&cp);
-	    if(dim > 2) data->z[k] = next_real(&cp);
+      /* The first physical tag of the entity, if any, is used to map the 
+	 entity tags of the elements. */
+      k = 0;
+      for(tagdim=0;tagdim<=3;tagdim++) {
+	if(numEnt[tagdim] > 0) printf("Reading %d entities in %dD\n",numEnt[tagdim],tagdim);
+	maxtag[tagdim] = 0;
+
+	for(i=0;i<numEnt[tagdim];i++,k++) {
+	  if(binary) {
+	    enttag[k] = GmshBinaryInt(&cp);
+	    cp += sizeof(double) * ((tagdim == 0) ? 3 : 6);
+	    nophys = GmshBinarySize(&cp,datasize);
+	    entphys[k] = (nophys > 0) ? GmshBinaryInt(&cp) : 0;
+	    if(nophys > 1) cp += (nophys-1)*sizeof(int);
+	    if(tagdim > 0) {
+	      j = GmshBinarySize(&cp,datasize);
+	      cp += j * sizeof(int);
+	    }
 	  }
 	  else {
-	    maxindx = MAX(ind,maxindx);
+	    enttag[k] = ParseInt(&cp);
+	    for(j=0;j < ((tagdim == 0 && minor >= 1) ? 3 : 6);j++) 
+	      ParseReal(&cp);
+	    nophys = ParseInt(&cp);
+	    entphys[k] = (nophys > 0) ? ParseInt(&cp) : 0;
+	    cp = GmshNextLine(cp,end);
 	  }
+	  maxtag[tagdim] = MAX(maxtag[tagdim],enttag[k]);
 	}
+	if(maxtag[tagdim] > 0) 
+	  printf("Maximum original tag for %d %dDIM entities is %d\n",numEnt[tagdim],tagdim,maxtag[tagdim]);
+	tagsize = MAX(tagsize,maxtag[tagdim]);
       }
-      GETLINE;
 
-      if(!strstr(line,"$EndNodes")) {
-	printf("$Nodes section should end to string $EndNodes:\n%s\n",line);
-      }           
-    }
+      if(tagsize > 0) {
+	tagmap = Imatrix(0,3,1,tagsize);
+	for(i=0;i<=3;i++)
+	  for(j=1;j<=tagsize;j++)
+	    tagmap[i][j] = 0;
+	k = 0;
+	for(tagdim=0;tagdim<=3;tagdim++) 
+	  for(i=0;i<numEnt[tagdim];i++,k++) 
+	    if(enttag[k] > 0) tagmap[tagdim][enttag[k]] = entphys[k];
+      }
+      free_Ivector(enttag,0,noent);
+      free_Ivector(entphys,0,noent);
 
-    else if(strstr(line,"$Entities")) {
-      int numPoints, numCurves, numSurfaces, numVolumes, numEnt;
-      int tag,tagdim,nophys,phystag,maxtag[4];
-      int nobound, idum;
-      Real rdum;
-      
-      GETLINE;
-      cp = line;
-      numPoints = next_int(&cp);
-      numCurves = next_int(&cp);
-      numSurfaces = next_int(&cp);
-      numVolumes = next_int(&cp);
+      cp = GmshSectionEnd(cp,end,"Entities");
+    }
 
+    else if(!strncmp(cp,"$Nodes",6)) {
+      int tagEntity,dimEntity,parEntity,numNodes,done,m,step;
       
-      if(allocated) {
-	tagsize = 0;
-	for(tagdim=0;tagdim<=3;tagdim++)
-	  tagsize = MAX( tagsize, maxtag[tagdim]);
-	if( tagsize > 0 ) {
-	  tagmap = Imatrix(0,3,1,tagsize);
-	  for(i=0;i<=3;i++)
-	    for(j=1;j<=tagsize;j++)
-	      tagmap[i][j] = 0;
-	}
+      cp = GmshNextLine(cp,end);
+      if(binary) {
+	numblocks = GmshBinarySize(&cp,datasize);
+	noknots = GmshBinarySize(&cp,datasize);
+	cp += 2*datasize;
       }
-      
-      for(tagdim=0;tagdim<=3;tagdim++) {	
-
-	
-	if( tagdim == 0 ) 
-	  numEnt = numPoints;
-	else if( tagdim == 1 )
-	  numEnt = numCurves;
-	else if( tagdim == 2 )
-	  numEnt = numSurfaces;
-	else if( tagdim == 3 )
-	  numEnt = numVolumes;
-	
-	if(!allocated)
-	  maxtag[tagdim] = 0;
-	else if( maxtag[tagdim] > 0 )
-	  printf("Maximum original tag for %d %dDIM entities is %d\n",numEnt,tagdim,maxtag[tagdim]);
-
-	if(numEnt > 0 && !allocated) printf("Reading %d entities in %dD\n",numEnt,tagdim);
-
-	
-	for(i=1; i <= numEnt; i++) {
-	  GETLONGLINE;
+      else {
+	numblocks = ParseInt(&cp);
+	noknots = ParseInt(&cp);
+	cp = GmshNextLine(cp,end);
+      }
+      if(info) printf("Reading %d nodes in %d blocks.\n",noknots,numblocks);
+      if(noknots <= 0) bigerror("No nodes to load in Gmsh file!");
 
-	  // if( i==1 ) printf("1st line of dim %d with %d entries: %s\n",tagdim,numEnt,line);
-	  
-	  if( tagdim == 0 ) continue;
-	  
-	  cp = longline;
-	  tag = next_int(&cp);
-	 	  
-	  if(!allocated)
-	    maxtag[tagdim] = MAX( maxtag[tagdim], tag );
-	  
-	  for(j=1;j<=6;j++) rdum = next_real(&cp);
-	  nophys = next_int(&cp);
+      data->noknots = noknots;
+      data->x = Rvector(1,noknots);
+      data->y = Rvector(1,noknots);
+      data->z = Rvector(1,noknots);
+      nodetag = Ivector(1,noknots);
 
-	  if( nophys > 0 ) phystag = next_int(&cp);
-	  
-	  if(allocated) tagmap[tagdim][tag] = phystag;
+      if(!binary) InitLineWindow(&lw,cp,end);
+      k = 0;
 
+      for(j=1; j <= numblocks; j++) {
+	if(binary) {
+	  dimEntity = GmshBinaryInt(&cp);
+	  tagEntity = GmshBinaryInt(&cp);
+	  parEntity = GmshBinaryInt(&cp);
+	  numNodes = GmshBinarySize(&cp,datasize);
+	  step = 3 + (parEntity ? dimEntity : 0);
+	}
+	else {
+	  if(!TakeLines(&lw,1,1,&lines)) break;
+	  cp = lines[0];
+	  if(minor >= 1) {
+	    dimEntity = ParseInt(&cp);
+	    tagEntity = ParseInt(&cp);
+	  }
+	  else {
+	    tagEntity = ParseInt(&cp);
+	    dimEntity = ParseInt(&cp);
+	  }
+	  parEntity = ParseInt(&cp);
+	  numNodes = ParseInt(&cp);
+	}
+	if(k + numNodes > noknots) {
+	  printf("LoadGmshInput4: There are more nodes in the blocks than %d!\n",noknots);
+	  bigerror("Invalid $Nodes section in Gmsh file!");
+	}
 
-	  // The lines may be too long. So fill the string buffer until we get a newline. 
-	  j = k = 0;
-	  for(;;) { 
-	    for(l=0;l<LONGLINESIZE;l++) {
-	      if( longline[l] == '\n') {
-		j = l;
-	    	break;	    
-	      }
+	if(binary) {
+	  const char *tags = cp, *coords = cp + (size_t) numNodes * datasize;
+
+#pragma omp parallel for 
+	  for(i=0;i<numNodes;i++) {
+	    const char *p = tags + (size_t) i*datasize;
+	    const char *q = coords + (size_t) i*step*sizeof(double);
+	    nodetag[k+i+1] = GmshBinarySize(&p,datasize);
+	    data->x[k+i+1] = GmshBinaryReal(q);
+	    data->y[k+i+1] = GmshBinaryReal(q+sizeof(double));
+	    data->z[k+i+1] = (dim > 2) ? GmshBinaryReal(q+2*sizeof(double)) : 0.0;
+	  }
+	  cp = coords + (size_t) numNodes*step*sizeof(double);
+	}
+	else if(minor >= 1) {
+	  /* In version 4.1 the tags and the coordinates are given in separate lines */
+	  for(done=0;done<numNodes;done+=m) {
+	    m = TakeLines(&lw,1,numNodes-done,&lines);
+	    if(!m) break;
+#pragma omp parallel for 
+	    for(i=0;i<m;i++) {
+	      const char *p = lines[i];
+	      nodetag[k+done+i+1] = ParseInt(&p);
 	    }
-	    if(j) break;
-	    k += LONGLINESIZE;
-	    GETLONGLINE;
-	  }	   	    	      
-	  if( k > 0 && !allocated) printf("Entity line %d has length %d.\n",i,k+j);
-	  
-	  //for(j=2;j<=nophys;j++)
-	  //  idum = next_int(&cp);
-
-	  //// if( tagdim == 0 ) continue;
-
-	  //nobound = next_int(&cp);
-	  // for(j=1;j<=nobound;j++)
-	  //  idum = next_int(&cp);	  
+	  }
+	  for(done=0;done<numNodes;done+=m) {
+	    m = TakeLines(&lw,1,numNodes-done,&lines);
+	    if(!m) break;
+#pragma omp parallel for 
+	    for(i=0;i<m;i++) {
+	      const char *p = lines[i];
+	      data->x[k+done+i+1] = ParseReal(&p);
+	      data->y[k+done+i+1] = ParseReal(&p);
+	      data->z[k+done+i+1] = (dim > 2) ? ParseReal(&p) : 0.0;
+	    }
+	  }
+	}
+	else {
+	  for(done=0;done<numNodes;done+=m) {
+	    m = TakeLines(&lw,1,numNodes-done,&lines);
+	    if(!m) break;
+#pragma omp parallel for 
+	    for(i=0;i<m;i++) {
+	      const char *p = lines[i];
+	      nodetag[k+done+i+1] = ParseInt(&p);
+	      data->x[k+done+i+1] = ParseReal(&p);
+	      data->y[k+done+i+1] = ParseReal(&p);
+	      data->z[k+done+i+1] = (dim > 2) ? ParseReal(&p) : 0.0;
+	    }
+	  }
 	}
+	k += numNodes;
       }
-      
-      GETLONGLINE;
-      if(!strstr(longline,"$EndEntities")) {
-	printf("$Entities section should end to string $EndEntities:\n%s\n",longline);
-      }           
-    }
-
-    else if(strstr(line,"$Elements")) {
-      int numEntityBlocks, numElements, tagEntity, dimEntity, typeEle, NumElements;
-      
-      GETLINE;
-      cp = line;
 
-      k = 0;
-      numEntityBlocks = next_int(&cp);
-      noelements = next_int(&cp);
-
-      if(allocated) printf("Reading %d elements in %d blocks.\n",noelements,numEntityBlocks);
+      if(!binary) {
+	cp = LineWindowPosition(&lw);
+	FreeLineWindow(&lw);
+      }
+      if(k != noknots) {
+	printf("LoadGmshInput4: Only %d nodes out of %d were found in the blocks!\n",k,noknots);
+	bigerror("Invalid $Nodes section in Gmsh file!");
+      }
+      cp = GmshSectionEnd(cp,end,"Nodes");
+    }
 
+    else if(!strncmp(cp,"$Elements",9)) {
+      int tagEntity,dimEntity,numElements,elemnodes,done,m,sweep;
       
-      for(j=1; j<= numEntityBlocks; j++ ) {
+      cp = GmshNextLine(cp,end);
+      if(binary) {
+	numblocks = GmshBinarySize(&cp,datasize);
+	noelements = GmshBinarySize(&cp,datasize);
+	cp += 2*datasize;
+      }
+      else {
+	numblocks = ParseInt(&cp);
+	noelements = ParseInt(&cp);
+	cp = GmshNextLine(cp,end);
+      }
+      if(info) printf("Reading %d elements in %d blocks.\n",noelements,numblocks);
+      if(noelements <= 0) bigerror("No elements to load in Gmsh file!");
+
+      blockdim = Ivector(1,numblocks);
+      blocktag = Ivector(1,numblocks);
+      blocktype = Ivector(1,numblocks);
+      blocksize = Ivector(1,numblocks);
+      cp0 = cp;
+
+      /* The first sweep is over the block headers only */
+      for(sweep=1;sweep<=2;sweep++) {
+	cp = cp0;
+	if(!binary) InitLineWindow(&lw,cp,end);
+	k = 0;
 	
-	GETLINE;	
-	cp = line;
-
-	tagEntity = next_int(&cp);
-	dimEntity = next_int(&cp);
+	for(j=1; j <= numblocks; j++ ) {
+	  if(binary) {
+	    blockdim[j] = GmshBinaryInt(&cp);
+	    blocktag[j] = GmshBinaryInt(&cp);
+	    blocktype[j] = GmshToElmerType(GmshBinaryInt(&cp));
+	    blocksize[j] = GmshBinarySize(&cp,datasize);
+	  }
+	  else {
+	    if(!TakeLines(&lw,1,1,&lines)) bigerror("Invalid $Elements section in Gmsh file!");
+	    cp = lines[0];
+	    if(minor >= 1) {
+	      blockdim[j] = ParseInt(&cp);
+	      blocktag[j] = ParseInt(&cp);
+	    }
+	    else {
+	      blocktag[j] = ParseInt(&cp);
+	      blockdim[j] = ParseInt(&cp);
+	    }
+	    blocktype[j] = GmshToElmerType(ParseInt(&cp));
+	    blocksize[j] = ParseInt(&cp);
+	  }
+	  elementtype = blocktype[j];
+	  elemnodes = elementtype % 100;
+	  numElements = blocksize[j];
+	  
+	  if(k + numElements > noelements) {
+	    printf("LoadGmshInput4: There are more elements in the blocks than %d!\n",noelements);
+	    bigerror("Invalid $Elements section in Gmsh file!");
+	  }
+	  
+	  if(sweep == 1) {
+	    if(binary && !elementtype) bigerror("Cannot skip unknown elements in binary Gmsh file!");
+	    maxnodes = MAX(maxnodes,elemnodes);
+	    if(binary) 
+	      cp += (size_t) numElements * (1+elemnodes) * datasize;
+	    else
+	      for(done=0;done<numElements;done+=m) 
+		if(!(m = TakeLines(&lw,1,numElements-done,&lines))) break;
+	    k += numElements;
+	    continue;
+	  }
 
-	typeEle = next_int(&cp);
-	numElements = next_int(&cp);
-	
-	elementtype = GmshToElmerType(typeEle);
-	elemnodes = elementtype % 100;
-	maxelemtype = MAX(maxelemtype,elementtype);
-	
-	if( allocated && tagsize > 0 ) {
-	  printf("Reading %d elements with tag %d of type %d\n", numElements, tagEntity, elementtype);
-	  if( tagsize > 0 ) {
-	    if( tagmap[dimEntity][tagEntity] ) {
-	      printf("Mapping mesh tag %d to physical tag %d in %dDIM\n",tagEntity,tagmap[dimEntity][tagEntity],dimEntity);	    
+	  tagEntity = blocktag[j];
+	  dimEntity = blockdim[j];
+	  if(tagsize > 0) {
+	    if(info) printf("Reading %d elements with tag %d of type %d\n",numElements,tagEntity,elementtype);
+	    if(dimEntity >= 0 && dimEntity <= 3 && tagEntity > 0 && tagEntity <= tagsize &&
+	       tagmap[dimEntity][tagEntity]) {
+	      if(info) printf("Mapping mesh tag %d to physical tag %d in %dDIM\n",
+			      tagEntity,tagmap[dimEntity][tagEntity],dimEntity);	    
 	      tagEntity = tagmap[dimEntity][tagEntity];
 	    }
 	    else {
 	      printf("Mesh tag %d is not associated to any physical tag!\n",tagEntity);
 	    }
 	  }
-	}
-			     
-	for(i=1; i <= numElements; i++) {
-	  GETLINE;	
-	  cp = line;
-
-	  k += 1;
-	  	  
-	  elemno = next_int(&cp);
 	  
-	  if(allocated) {
-	    data->elementtypes[k] = elementtype;
-	    data->material[k] = tagEntity;
-	    for(l=0;l<elemnodes;l++)
-	      elemind[l] = next_int(&cp);
-
-	    GmshToElmerIndx(elementtype,elemind);	  
-
-	    for(l=0;l<elemnodes;l++)
-	      data->topology[k][l] = elemind[l];
-	  }	
-	}
-      }
-
-      GETLINE;
-      if(!strstr(line,"$EndElements")) {
-	printf("$Elements section should end to string $EndElements:\n%s\n",line);
-      }   
-    }
-
-    else if(strstr(line,"$PhysicalNames")) {
-      GETLINE;
-      cp = line;
-      nophysical = next_int(&cp);
-      for(i=0;i<nophysical;i++) {
-	GETLINE;
-        if(allocated) {
-	  cp = line;
-	  gmshtype = next_int(&cp);
-	  tagphys = next_int(&cp);
-	  if(gmshtype == dim-1) {
-	    physsurfexist = TRUE;
-	    if(tagphys < MAXBCS) {
-	      sscanf(cp," \"%[^\"]\"",data->boundaryname[tagphys]);
-	      printf("Boundary name for physical group %d is: %s\n",tagphys,data->boundaryname[tagphys]);
+	  if(binary) {
+	    const char *recs = cp;
+	    
+#pragma omp parallel for 
+	    for(i=0;i<numElements;i++) {
+	      int l,*ind;
+	      const char *p = recs + ((size_t) i * (1+elemnodes) + 1) * datasize;
+	      data->elementtypes[k+i+1] = elementtype;
+	      data->material[k+i+1] = tagEntity;
+	      ind = data->topology[k+i+1];
+	      for(l=0;l<elemnodes;l++)
+		ind[l] = GmshBinarySize(&p,datasize);
+	      GmshToElmerIndx(elementtype,ind);
 	    }
-	    else
-	      printf("Index %d too high: ignoring physical %s %s",tagphys,manifoldname[dim-1],cp+1);
+	    cp = recs + (size_t) numElements * (1+elemnodes) * datasize;
 	  }
-	  else if(gmshtype == dim) {
-	    physvolexist = TRUE;
-	    if(tagphys < MAXBODIES) {
-	      sscanf(cp," \"%[^\"]\"",data->bodyname[tagphys]);
-	      printf("Body name for physical group %d is: %s\n",tagphys,data->bodyname[tagphys]);
+	  else {
+	    for(done=0;done<numElements;done+=m) {
+	      m = TakeLines(&lw,1,numElements-done,&lines);
+	      if(!m) break;
+#pragma omp parallel for 
+	      for(i=0;i<m;i++) {
+		int l,*ind;
+		const char *p = lines[i];
+		ParseInt(&p);
+		data->elementtypes[k+done+i+1] = elementtype;
+		data->material[k+done+i+1] = tagEntity;
+		ind = data->topology[k+done+i+1];
+		for(l=0;l<elemnodes;l++)
+		  ind[l] = ParseInt(&p);
+		GmshToElmerIndx(elementtype,ind);
+	      }
 	    }
-	    else
-	      printf("Index %d too high: ignoring physical %s %s",tagphys,manifoldname[dim],cp+1);
 	  }
-	  else printf("Physical groups of dimension %d not supported in %d-dimensional mesh: "
-		      "ignoring group %d %s",gmshtype,dim,tagphys,cp+1);
-        }
+	  k += numElements;
+	}
+	
+	if(!binary) {
+	  cp = LineWindowPosition(&lw);
+	  FreeLineWindow(&lw);
+	}
+	if(k != noelements) {
+	  printf("LoadGmshInput4: Only %d elements out of %d were found in the blocks!\n",k,noelements);
+	  bigerror("Invalid $Elements section in Gmsh file!");
+	}
+
+	if(sweep == 1) {
+	  if(info) printf("Allocating for %d elements with at most %d nodes.\n",noelements,maxnodes);
+	  data->noelements = noelements;
+	  data->maxnodes = maxnodes;
+	  data->topology = Imatrix(1,noelements,0,maxnodes-1);
+	  data->material = Ivector(1,noelements);
+	  data->elementtypes = Ivector(1,noelements);
+	}
       }
+      free_Ivector(blockdim,1,numblocks);
+      free_Ivector(blocktag,1,numblocks);
+      free_Ivector(blocktype,1,numblocks);
+      free_Ivector(blocksize,1,numblocks);
 
-      GETLINE;
-      if(!strstr(line,"$EndPhysicalNames")) {
-	printf("$PhysicalNames section should end to string $EndPhysicalNames:\n%s\n",line);
-      }   
-    }
-    else if(strstr(line,"$Periodic")) {
-      int numPeriodicLinks;
-      if(allocated) printf("Reading periodic links but doing nothing with them!\n");
-      
-      GETLINE;
-      cp = line;
-      numPeriodicLinks = next_int(&cp);
-      for(i=1; i <= numPeriodicLinks; i++) {
-	GETLINE;
-      }     
-      GETLINE;
-      if(!strstr(line,"$EndPeriodic")) {
-	printf("$Periodic section should end to string $EndPeriodic:\n%s\n",line);
-      }           
+      cp = GmshSectionEnd(cp,end,"Elements");
     }
 
-    else if(strstr(line,"$PartitionedEntities")) {
-      if(allocated) printf("Reading partitioned entities but doing nothing with them!\n");      
-      for(;;) {
-	GETLINE;
-	if(strstr(line,"$EndPartitionedEntities")) break;
-      }
+    else if(*cp == '$') {
+      for(j=0;j < MAXLINESIZE-1 && cp+j < end && !isspace((unsigned char) cp[j]);j++)
+	line[j] = cp[j];
+      line[j] = '\0';
+      if(info) printf("Reading section %s but doing nothing with it!\n",line);
+      cp = GmshSectionEnd(cp,end,line+1);
     }
-    else if(strstr(line,"$NodeData")) {
-      if(allocated) printf("Reading node data but doing nothing with them!\n");      
-      for(;;) {
-	GETLINE;
-	if(strstr(line,"$EndNodeData")) break;
-      }
-    }
-    else if(strstr(line,"$ElementData")) {
-      if(allocated) printf("Reading element data but doing nothing with them!\n");      
-      for(;;) {
-	GETLINE;
-	if(strstr(line,"$EndElementData")) break;
-      }
-    }
-    else if(strstr(line,"$ElementNodeData")) {
-      if(allocated) printf("Reading element node data but doing nothing with them!\n");      
-      for(;;) {
-	GETLINE;
-	if(strstr(line,"$EndElementNodeData")) break;
-      }
-    }
-    else if(strstr(line,"$GhostElements")) {
-      if(allocated) printf("Reading ghost elements data but doing nothing with them!\n");      
-      for(;;) {
-	GETLINE;
-	if(strstr(line,"$EndGhostElements")) break;
-      }
-    }
-    else if(strstr(line,"$InterpolationScheme")) {
-      if(allocated) printf("Reading interpolation scheme but doing nothing with them!\n");      
-      for(;;) {
-	GETLINE;
-	if(strstr(line,"$EndInterpolationScheme")) break;
-      }
-    }    
+
     else {
-      if(allocated) printf("Untreated command: %s",line);
+      if(info) printf("Untreated line at offset %ld\n",(long) (cp-mf.buf));
+      cp = GmshNextLine(cp,end);
     }
-
   }
 
- end:
-
-
-  if(!allocated) {
-    if( noelements == 0 ) bigerror("No elements to load in Gmsh file!");
-    if( noknots == 0 ) bigerror("No nodes to load in Gmsh file!");
-
-    maxnodes = maxelemtype % 100;
-    InitializeKnots(data);
-    data->dim = dim;
-    data->maxnodes = maxnodes;
-    data->noelements = noelements;
-    data->noknots = noknots;
+  UnmapFile(&mf);
 
-    if(info) printf("Allocating for %d knots and %d elements.\n",noknots,noelements);
-    AllocateKnots(data);
+  if( noelements == 0 ) bigerror("No elements to load in Gmsh file!");
+  if( noknots == 0 ) bigerror("No nodes to load in Gmsh file!");
+  data->created = TRUE;
 
-    if(maxindx > noknots) {
-      revindx = Ivector(1,maxindx);
-      for(i=1;i<=maxindx;i++) revindx[i] = 0;
-    }
-    rewind(in);
-    allocated = TRUE;
-    goto omstart;
+  /* The node tags need not be continuous, nor in order */
+  maxindx = 0;
+  renumber = FALSE;
+#pragma omp parallel for reduction(max:maxindx) reduction(||:renumber)
+  for(i=1;i<=noknots;i++) {
+    maxindx = MAX(maxindx,nodetag[i]);
+    if(nodetag[i] != i) renumber = TRUE;
   }
 
-  if(maxindx > noknots) {
+  if(renumber) {
     printf("Renumbering the Gmsh nodes from %d to %d\n",maxindx,noknots);
 
-    for(i=1; i <= noelements; i++) {
-      elementtype = data->elementtypes[i];
-      elemnodes = elementtype % 100; 
+    revindx = Ivector(1,maxindx);
+    for(i=1;i<=maxindx;i++) revindx[i] = 0;
+    for(i=1;i<=noknots;i++) 
+      if(nodetag[i] > 0) revindx[nodetag[i]] = i;
 
-      for(j=0;j<elemnodes;j++) {
+#pragma omp parallel for private(j,k)
+    for(i=1; i <= noelements; i++) {
+      for(j=0;j<data->elementtypes[i]%100;j++) {
 	k = data->topology[i][j];
 	if(k <= 0 || k > maxindx) 
 	  printf("index out of bounds %d\n",k);
@@ -4112,6 +4551,7 @@ omstart:
     }
     free_Ivector(revindx,1,maxindx);
   }
+  free_Ivector(nodetag,1,noknots);
 
   ElementsToBoundaryConditions(data,bound,FALSE,info);
 
@@ -4507,7 +4947,8 @@ int LoadUniversalMesh(struct FemType *data,struct BoundaryType *bound,
 		      char *prefix,int info)
 /* Load the grid in universal file format. This format includes thousands of possible 
    fields and hence the parser can never be exhaustive. Just the mostly common used
-   fields in FE community are treated. */
+   fields in FE community are treated. The file is mapped to memory and the node and 
+   element datasets, that are the bulk of the data, are parsed in parallel. */
 {
   int noknots,totknots,noelements,elemcode,maxnodes;
   int allocated,dim,ind,lines;
@@ -4516,18 +4957,21 @@ int LoadUniversalMesh(struct FemType *data,struct BoundaryType *bound,
   int minelemtype,maxelemtype,physoffset=0,doscaling=FALSE;
   int debug,mingroup,maxgroup,minphys,maxphys,nogroup,noentities,dummy;
   int *u2eind=NULL,*u2eelem=NULL;
-  int *elementtypes;
+  int *elementtypes,*ival=NULL;
   char filename[MAXFILESIZE],line[MAXLINESIZE],*cp;
   int i,j,k;
+  long m,maxm,l,t;
   char entityname[MAXNAMESIZE];
   Real scaling[4];
-  FILE *in;
+  struct MappedFile mf;
+  struct LineWindow lw;
+  const char **wl;
 
 
   strcpy(filename,prefix);
-  if ((in = fopen(filename,"r")) == NULL) {
+  if (MapFile(filename,&mf)) {
     AddExtension(prefix,filename,"unv");
-    if ((in = fopen(filename,"r")) == NULL) {
+    if (MapFile(filename,&mf)) {
       printf("LoadUniversalMesh: opening of the universal mesh file '%s' wasn't succesfull !\n",
 	     filename);
       return(1);
@@ -4555,6 +4999,8 @@ int LoadUniversalMesh(struct FemType *data,struct BoundaryType *bound,
   maxgroup = 0;
   minphys = INT_MAX;
   maxphys = 0;
+  maxm = 0;
+  InitLineWindow(&lw,mf.buf,mf.buf+mf.size);
     
 omstart:
 
@@ -4582,7 +5028,7 @@ omstart:
 
   nextline:
     if( !strncmp(line,"    -1",6)) mode = 0;
-    if( Getrow(line,in,FALSE)) {
+    if( WindowGetrow(line,&lw)) {
       goto end;
     }
     if(line[0]=='\0') goto end;
@@ -4601,96 +5047,146 @@ omstart:
 
     if(debug && mode) printf("Current mode is %d\n",mode);
 
-    /* node definition */
+    /* node definition, each node takes two lines */
     if( mode == 2411 || mode == 781 ) {
       if(allocated && info) printf("Reading node coordinates\n");
       for(;;) {
-	GetrowDouble(line,in);
-	if( !strncmp(line,"    -1",6)) {
-	  if(!allocated && info) printf("There are %d nodes in the mesh\n",noknots);
-	  goto nextline;
-	}
-
-	cp = line;
-	nodeind = next_int(&cp);
-	/* Three other fields omitted: two coordinate systems and color */
-	noknots += 1;
-	GetrowDouble(line,in);
+	m = TakeLines(&lw,2,LONG_MAX,&wl);
 
+	/* The node lines never start as the terminating line */
+	t = m;
+#pragma omp parallel for reduction(min:t)
+	for(l=0;l<m;l+=2)
+	  if(!strncmp(wl[l],"    -1",6)) t = MIN(t,l);
+	
+	k = (int) (t/2);
 	if(allocated) {
-	  if(reordernodes) {
-	    if(u2eind[nodeind]) 
-	      printf("Reordering node %d already set (%d vs. %d)\n",
-		     nodeind,u2eind[nodeind],noknots);
-	    else
-	      u2eind[nodeind] = noknots;
+#pragma omp parallel for 
+	  for(i=0;i<k;i++) {
+	    const char *p = wl[2*i];
+	    int ind = noknots+i+1;
+	    int nodeind = ParseInt(&p);
+	    if(reordernodes) {
+	      if(u2eind[nodeind]) 
+		printf("Reordering node %d already set (%d vs. %d)\n",
+		       nodeind,u2eind[nodeind],ind);
+	      else
+		u2eind[nodeind] = ind;
+	    }
+	    p = wl[2*i+1];
+	    data->x[ind] = ParseReal(&p);
+	    data->y[ind] = ParseReal(&p);
+	    data->z[ind] = ParseReal(&p);
 	  }
-
-	  cp = line;
-	  data->x[noknots] = next_real(&cp);
-	  data->y[noknots] = next_real(&cp);
-	  data->z[noknots] = next_real(&cp);
 	}
 	else {
-	  if(nodeind != noknots) reordernodes = TRUE;
-	  maxnodeind = MAX(maxnodeind,nodeind);
+#pragma omp parallel for reduction(max:maxnodeind) reduction(||:reordernodes)
+	  for(i=0;i<k;i++) {
+	    const char *p = wl[2*i];
+	    int nodeind = ParseInt(&p);
+	    if(nodeind != noknots+i+1) reordernodes = TRUE;
+	    maxnodeind = MAX(maxnodeind,nodeind);
+	  }
 	}
+	noknots += k;
+	linenumber += 2*k;
+
+	if( t < m || k == 0 ) {
+	  /* Leave the lines after the terminating line to the window */
+	  if( t < m ) {
+	    UntakeLines(&lw,m-t-1);
+	    linenumber += 1;
+	  }
+	  if(!allocated && info) printf("There are %d nodes in the mesh\n",noknots);
+	  strcpy(line,"    -1");
+	  goto nextline;
+	}
+	UntakeLines(&lw,m-2*k);
       }
     }
 
     if( mode == 2412 ) {
+      int c,rec;
       minelemtype = INT_MAX;
       maxelemtype = 0;
 
       if(allocated && info) printf("Reading element topologies\n");
       for(;;) {
-	Getrow(line,in,FALSE);
-	if( strstr(line,"-1")) {
-	  if(info && !allocated) printf("Element type range in mesh [%d,%d]\n",minelemtype,maxelemtype);
-	  goto nextline;
-	}	
+	/* The integers of the lines are first parsed in parallel to a table and 
+	   the records are then interpreted one by one. A record has at most four lines. */
+	m = TakeLines(&lw,4,LONG_MAX,&wl);
+	if(m > maxm) {
+	  free(ival);
+	  maxm = m;
+	  ival = (int*) malloc((size_t) 8*maxm*sizeof(int));
+	  if(!ival) nrerror("allocation failure in LoadUniversalMesh()");
+	}
 
-	noelements += 1;
-	cp = line;
-	elid = next_int(&cp);
-	unvtype = next_int(&cp);
-	physind = next_int(&cp);
-	matind = next_int(&cp);
-	colorind = next_int(&cp);
-	nonodes = next_int(&cp);
+#pragma omp parallel for 
+	for(l=0;l<m;l++) {
+	  const char *p = wl[l];
+	  int j;
+	  for(j=0;j<8;j++)
+	    ival[8*l+j] = ParseInt(&p);
+	}
 
-	if(!allocated ) {
-	  if(0) printf("elem = %d %d %d %d\n",noelements,unvtype,physind,matind);
-	}	
+	for(l=0;l<m;l+=rec) {
+	  for(cp=(char*) wl[l];cp+1 < wl[l+1];cp++) 
+	    if(cp[0] == '-' && cp[1] == '1') break;
+	  if(cp+1 < wl[l+1]) {
+	    UntakeLines(&lw,m-l-1);
+	    linenumber += 1;
+	    if(info && !allocated) printf("Element type range in mesh [%d,%d]\n",minelemtype,maxelemtype);
+	    strcpy(line,"    -1");
+	    goto nextline;
+	  }	
 
-	if (!allocated) {
-	  minphys = MIN( minphys, physind );
-	  maxphys = MAX( maxphys, physind );	 
-	  maxnodes = MAX(maxnodes, nonodes);
-	  if(elid != noelements) reorderelements = TRUE;
-	  maxelem = MAX(maxelem, elid);
-	}
-	
-	if(unvtype == 11 || unvtype == 21 || unvtype == 22 ) Getrow(line,in,FALSE);
-	Getrow(line,in,FALSE);
-	cp = line;
+	  elid = ival[8*l];
+	  unvtype = ival[8*l+1];
+	  physind = ival[8*l+2];
+	  matind = ival[8*l+3];
+	  colorind = ival[8*l+4];
+	  nonodes = ival[8*l+5];
 
-	elmertype = UnvToElmerType(unvtype); 
-	if(!elmertype) {
-	  printf("Unknown elementtype %d %d %d %d %d %d %d\n",
-		 noelements,elid,unvtype,physind,matind,colorind,nonodes);
-	  printf("line %d: %s\n",linenumber,line);
-	  bigerror("done");
-	}
+	  /* The first line of the indexes */
+	  c = l+1;
+	  if(unvtype == 11 || unvtype == 21 || unvtype == 22 ) c++;
+	  
+	  elmertype = UnvToElmerType(unvtype); 
+	  if(!elmertype) {
+	    printf("Unknown elementtype %d %d %d %d %d %d %d\n",
+		   noelements+1,elid,unvtype,physind,matind,colorind,nonodes);
+	    printf("line %d\n",linenumber+c-l);
+	    bigerror("done");
+	  }
 
-	if(elmertype == 510 ) 	   
-	  lines = 1;
-	else if(elmertype == 820 ) 
-	  lines = 2;
-	else
-	  lines = 0;
+	  if(elmertype == 510 ) 	   
+	    lines = 1;
+	  else if(elmertype == 820 ) 
+	    lines = 2;
+	  else
+	    lines = 0;
+
+	  rec = c-l+1+lines;
+	  if(l+rec > m) {
+	    if(l == 0) bigerror("Unexpected end of element records in universal file!");
+	    UntakeLines(&lw,m-l);
+	    break;
+	  }
+	  linenumber += rec;
+	  noelements += 1;
+	  
+	  if (!allocated) {
+	    minphys = MIN( minphys, physind );
+	    maxphys = MAX( maxphys, physind );	 
+	    maxnodes = MAX(maxnodes, nonodes);
+	    if(elid != noelements) reorderelements = TRUE;
+	    maxelem = MAX(maxelem, elid);
+	    minelemtype = MIN( minelemtype, elmertype );
+	    maxelemtype = MAX( maxelemtype, elmertype );
+	    continue;
+	  }
 
-	if(allocated) {
 	  if(reorderelements) u2eelem[elid] = noelements;
 
 	  if(debug && !elementtypes[elmertype]) {
@@ -4705,13 +5201,10 @@ omstart:
 	  
 	  data->elementtypes[noelements] = elmertype;
 	  for(i=0;i<nonodes;i++) {
-	    if( lines > 0 && i >= 8 ) {
-	      if( i%8 == 0 ) {
-		Getrow(line,in,FALSE);
-		cp = line;
-	      }
-	    }
-	    data->topology[noelements][i] = next_int(&cp);
+	    if( i < 8 ) 
+	      data->topology[noelements][i] = ival[8*c+i];
+	    else
+	      data->topology[noelements][i] = (lines > 0) ? ival[8*(c+i/8)+i%8] : 0;
 	  }
 
 	  UnvRedundantIndexes(nonodes,data->topology[noelements]);
@@ -4721,13 +5214,7 @@ omstart:
 	  /* should this be physical property or material property? */
 	  data->material[noelements] = physind + physoffset;
 	}
-	else {
-	  minelemtype = MIN( minelemtype, elmertype );
-	  maxelemtype = MAX( maxelemtype, elmertype );
-	  for(i=1;i<=lines;i++) {
-	    Getrow(line,in,FALSE);
-	  }	  
-	}
+	if(m == 0) goto end;
       }
     }
 
@@ -4736,18 +5223,18 @@ omstart:
       Real coeff;
       if(allocated && info) printf("Reading Coordinate system information\n");
 
-      Getrow(line,in,FALSE);
+      WindowGetrow(line,&lw);
       if( !allocated ) {
 	cp = line;
 	partuid = next_int(&cp);
 	printf("Part UID = %d\n",partuid);
       }	
-      Getrow(line,in,FALSE);
+      WindowGetrow(line,&lw);
       if(!allocated ) {
 	sscanf(line,"%s",entityname);
 	printf("Part name = %s\n",entityname);
       }      
-      Getrow(line,in,FALSE);
+      WindowGetrow(line,&lw);
       if( !allocated ) {
 	cp = line;
 	coordlabel = next_int(&cp);
@@ -4758,13 +5245,13 @@ omstart:
 	}
       }      
 
-      Getrow(line,in,FALSE);
+      WindowGetrow(line,&lw);
       if(!allocated ) {
 	sscanf(line,"%s",entityname);
 	printf("Coord system name = %s\n",entityname);
       }      
       for(i=1;i<=4;i++) {
-	Getrow(line,in,FALSE);
+	WindowGetrow(line,&lw);
 	if( !allocated ) {
 	  cp = line;
 	  if(!cp) printf("Problem reading line %d for coordinate system\n",i);
@@ -4789,7 +5276,7 @@ omstart:
 	  }	  
 	}      
       }
-      Getrow(line,in,FALSE);
+      WindowGetrow(line,&lw);
       if( strncmp(line,"    -1",6)) 
 	printf("Field 2420 should already be ending: %s\n",line); 
       goto nextline;
@@ -4802,7 +5289,7 @@ omstart:
 
       if(allocated && info) printf("Reading element groups in mode %d\n",mode);
       for(;;) {
-	Getrow(line,in,FALSE);
+	WindowGetrow(line,&lw);
 	if( !strncmp(line,"    -1",6)) goto nextline;
 	
 	noelements += 1;
@@ -4825,8 +5312,8 @@ omstart:
 	  maxphys = MAX( maxphys, physind );
 	}
 	
-	if(unvtype == 11 || unvtype == 21) Getrow(line,in,FALSE);
-	Getrow(line,in,FALSE);
+	if(unvtype == 11 || unvtype == 21) WindowGetrow(line,&lw);
+	WindowGetrow(line,&lw);
 	cp = line;
 	if(allocated) {
 	  if(reorderelements) u2eelem[elid] = noelements;
@@ -4863,7 +5350,7 @@ omstart:
       if(allocated && info) printf("Reading element groups in mode %d\n",mode);
       
       for(;;) {
-	Getrow(line,in,FALSE);
+	WindowGetrow(line,&lw);
 	if( !strncmp(line,"    -1",6)) goto nextline;
 	
 	cp = line;
@@ -4879,7 +5366,7 @@ omstart:
 	  maxgroup = MAX( maxgroup, nogroup );
 	}
 
-	Getrow(line,in,FALSE);	
+	WindowGetrow(line,&lw);	
 	if( !strncmp(line,"    -1",6)) goto nextline;
 	
 	/* Used for the empty group created by salome */
@@ -4896,11 +5383,11 @@ omstart:
 	  if(info) printf("Reading %d:th group with index %d with %d entities: %s\n",
 			  group,nogroup,noentities,entityname);
 	}
-	if(noentities == 0) Getrow(line,in,FALSE);
+	if(noentities == 0) WindowGetrow(line,&lw);
 
 	for(i=0;i<noentities;i++) {
 	  if(i%2 == 0) {
-	    Getrow(line,in,FALSE);
+	    WindowGetrow(line,&lw);
 	    if( !strncmp(line,"    -1",6)) goto nextline;
 	    cp = line;
 	  }	  
@@ -4947,7 +5434,7 @@ omstart:
     if( mode == 164 ) {
       if(!allocated) printf("Units dataset content is currently omitted!\n");
       for(;;) {
-	Getrow(line,in,FALSE);
+	WindowGetrow(line,&lw);
 	if( !strncmp(line,"    -1",6)) 
 	goto nextline;
       }
@@ -4977,11 +5464,13 @@ end:
     if(noknots == 0 || noelements == 0 || maxnodes == 0) {
       printf("Invalid mesh consists of %d nodes and %d %d-node elements.\n",
 	     noknots,noelements,maxnodes);     
-      fclose(in);
+      FreeLineWindow(&lw);
+      UnmapFile(&mf);
       return(2);
     }
 
-    rewind(in);
+    FreeLineWindow(&lw);
+    InitLineWindow(&lw,mf.buf,mf.buf+mf.size);
     totknots = noknots;
     data->noknots = noknots;
     data->noelements = noelements + nopoints;
@@ -5014,7 +5503,9 @@ end:
 
     goto omstart;    
   }
-  fclose(in);
+  FreeLineWindow(&lw);
+  UnmapFile(&mf);
+  free(ival);
 
   /* If the physical index may be zero, then we have a risk that there is 
      an unset material index. Elmer does not like material indexes of zeros. 
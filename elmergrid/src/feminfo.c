@@ -315,6 +315,7 @@ void InitParameters(struct ElmergridType *eg)
   eg->timeron = FALSE;
   eg->nosave = FALSE;
   eg->nooverwrite = FALSE;
+  eg->binarymesh = FALSE;
   eg->merge = FALSE;
   eg->bcoffset = FALSE;
   eg->periodic = 0;
@@ -970,6 +971,9 @@ int InlineParameters(struct ElmergridType *eg,int argc,char *argv[])
     if(strcmp(argv[arg],"-nooverwrite") == 0) {
       eg->nooverwrite = TRUE;
     }
+    if(strcmp(argv[arg],"-binary") == 0) {
+      eg->binarymesh = TRUE;
+    }
     if(strcmp(argv[arg],"-timer") == 0) {
       eg->timeron = TRUE;
     }
@@ -1309,6 +1313,10 @@ int LoadCommands(char *prefix,struct ElmergridType *eg,
       for(j=0;j<MAXLINESIZE;j++) params[j] = toupper(params[j]);
       if(strstr(params,"TRUE")) eg->partitionindirect = TRUE;      
     }
+    else if(strstr(command,"BINARY MESH")) {
+      for(j=0;j<MAXLINESIZE;j++) params[j] = toupper(params[j]);
+      if(strstr(params,"TRUE")) eg->binarymesh = TRUE;      
+    }
     else if(strstr(command,"BOUNDARY TYPE MAPPINGS")) {
       for(i=0;i<MAXMAPPINGS;i++) {
 	if(i>0) Getline(params,in);
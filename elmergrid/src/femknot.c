@@ -894,7 +894,7 @@ void InitializeKnots(struct FemType *data)
   data->partitiontableexists = FALSE;
 
   data->invtopo.created = FALSE;
-  data->nodalgraph2.created = FALSE;
+  data->nodalgraph.created = FALSE;
   data->dualgraph.created = FALSE;
 
   
@@ -5325,10 +5325,11 @@ int FindBoundaryBoundary(struct FemType *data,struct BoundaryType *bound,int mat
 
 int IncreaseElementOrder(struct FemType *data,int info)
 {
-  int i,j,side,element,maxcon,con,newknots,ind,ind2;
+  int i,j,side,element,con,newknots,ind,ind2;
   int noelements,noknots,nonodes,maxnodes,maxelemtype,hit,node;
-  int elemtype;
-  int **newnodetable=NULL,inds[2],**newtopo=NULL;
+  int elemtype,totcon;
+  int *newnodetable=NULL,inds[2],**newtopo=NULL;
+  int *rows,*cols;
   Real *newx=NULL,*newy=NULL,*newz=NULL;
   
   if(info) printf("Trying to increase the element order of current elements\n");
@@ -5337,21 +5338,23 @@ int IncreaseElementOrder(struct FemType *data,int info)
 
   noknots = data->noknots;
   noelements = data->noelements;
-  maxcon = data->nodalmaxconnections;
+  rows = data->nodalgraph.rows;
+  cols = data->nodalgraph.cols;
+  totcon = data->nodalgraph.colsize;
   maxnodes = 0;
 
-  newnodetable = Imatrix(0,maxcon-1,1,noknots);
-  for(i=1;i<=noknots;i++) 
-    for(j=0;j<maxcon;j++) 
-      newnodetable[j][i] = 0;
+  /* The new nodes are numbered following the entries of the nodal graph */
+  newnodetable = Ivector(0,totcon-1);
+  for(j=0;j<totcon;j++) 
+    newnodetable[j] = 0;
 
   newknots = 0;
   for(i=1;i<=noknots;i++) {
-    for(j=0;j<maxcon;j++) {
-      con = data->nodalgraph[j][i];
+    for(j=rows[i-1];j<rows[i];j++) {
+      con = cols[j]+1;
       if(con > i) {
 	newknots++;
-	newnodetable[j][i] = noknots + newknots;
+	newnodetable[j] = noknots + newknots;
       }
     }
   }
@@ -5369,10 +5372,10 @@ int IncreaseElementOrder(struct FemType *data,int info)
     newz[i] = data->z[i];
   }
   for(i=1;i<=noknots;i++) {
-    for(j=0;j<maxcon;j++) {
-      con = data->nodalgraph[j][i];
-      ind = newnodetable[j][i];
-      if(con && ind) {
+    for(j=rows[i-1];j<rows[i];j++) {
+      con = cols[j]+1;
+      ind = newnodetable[j];
+      if(ind) {
 	newx[ind] = 0.5*(data->x[i] + data->x[con]);
 	newy[ind] = 0.5*(data->y[i] + data->y[con]);
 	newz[ind] = 0.5*(data->z[i] + data->z[con]);
@@ -5427,11 +5430,11 @@ int IncreaseElementOrder(struct FemType *data,int info)
 	ind = inds[0];
 	ind2 = inds[1];
       }
-      for(j=0;j<maxcon;j++) {
-	con = data->nodalgraph[j][ind];
+      for(j=rows[ind-1];j<rows[ind];j++) {
+	con = cols[j]+1;
 
 	if(con == ind2) {
-	  node = newnodetable[j][ind];
+	  node = newnodetable[j];
 	  newtopo[element][nonodes+side] = node;
 	}
       }
@@ -5447,7 +5450,7 @@ int IncreaseElementOrder(struct FemType *data,int info)
   free_Rvector(data->y,1,data->noknots);
   free_Rvector(data->z,1,data->noknots);
   free_Imatrix(data->topology,1,data->noelements,0,data->maxnodes);
-  free_Imatrix(newnodetable,0,maxcon-1,1,noknots);
+  free_Ivector(newnodetable,0,totcon-1);
 
   data->x = newx;
   data->y = newy;
@@ -9590,178 +9593,94 @@ int RotateTranslateScale(struct FemType *data,struct ElmergridType *eg,int info)
 
 
 
-int CreateNodalGraph(struct FemType *data,int full,int info)
+static int CompareGraphKeys(const void *a,const void *b)
 {
-  int i,j,k,l,m,totcon,noelements, noknots,elemtype,nonodes,hit,ind,ind2;
-  int maxcon,percon,edge;
+  long long ka,kb;
+  ka = *(const long long*)a;
+  kb = *(const long long*)b;
+  return( (ka > kb) - (ka < kb) );
+}
 
-  printf("Creating a nodal graph of the finite element mesh\n");  
 
-  if(data->nodalexists) {
-    printf("The nodal graph already exists!\n");
-    smallerror("Nodal graph not done");
-    return(1);
-  }
+static int UniqueKeepFirst(int *cand,int n,long long *work)
+/* Removes the repeated entries of cand[0..n-1] keeping the first occurrence of each 
+   positive value and the original order. Returns the number of remaining entries. */
+{
+  int i,m;
 
-  maxcon = 0;
-  totcon = 0;
-  percon = 0;
-  noelements = data->noelements;
-  noknots = data->noknots;
+  if(n < 2) return(n);
 
-  for(i=1;i<=noelements;i++) {
-    elemtype = data->elementtypes[i];
+  for(i=0;i<n;i++)
+    work[i] = ((long long)cand[i] << 32) | i;
+  qsort(work,n,sizeof(long long),CompareGraphKeys);
+  
+  for(i=1;i<n;i++)
+    if( (work[i] >> 32) == (work[i-1] >> 32) ) 
+      cand[work[i] & 0xffffffffLL] = 0;
+
+  m = 0;
+  for(i=0;i<n;i++) 
+    if(cand[i]) cand[m++] = cand[i];
+
+  return(m);
+}
+
+
+static int NodalGraphRow(struct FemType *data,int full,int ind,struct CRSType *invtopo,
+			 int *cand,long long *work,int *periodic)
+/* Connections of node ind in the order they are met going through the elements. */
+{
+  int i,k,l,n,nonodes,ind2,edge,inds[2];
+
+  n = 0;
+  for(l=invtopo->rows[ind-1];l<invtopo->rows[ind];l++) {
+    i = invtopo->cols[l]+1;
 
     /* This sets only the connections resulting from element edges */
     if(!full) {
-      int inds[2];
       for(edge=0;;edge++) {
 	if( !GetElementGraph(i,edge,data,&inds[0]) ) break;
-
-	ind = inds[0];
-	ind2 = inds[1];
-
-	hit = FALSE;
-	for(l=0;l<maxcon;l++) { 
-	  if(data->nodalgraph[l][ind] == ind2) hit = TRUE;
-	  if(data->nodalgraph[l][ind] == 0) break;
-	}
-	if(!hit) {
-	  if(l >= maxcon) {
-	    data->nodalgraph[maxcon] = Ivector(1,noknots);
-	    for(m=1;m<=noknots;m++)
-	      data->nodalgraph[maxcon][m] = 0;
-	    maxcon++;
-	  }
-	  data->nodalgraph[l][ind] = ind2;
-	  totcon++;
-	}
-
-	/* Make also so symmetric connection */
-	for(l=0;l<maxcon;l++) { 
-	  if(data->nodalgraph[l][ind2] == ind) hit = TRUE;
-	  if(data->nodalgraph[l][ind2] == 0) break;
-	}
-	if(!hit) {
-	  if(l >= maxcon) {
-	    data->nodalgraph[maxcon] = Ivector(1,noknots);
-	    for(m=1;m<=noknots;m++)
-	      data->nodalgraph[maxcon][m] = 0;
-	    maxcon++;
-	  }
-	  data->nodalgraph[l][ind2] = ind;
-	  totcon++;
-	}
+	if(inds[0] == ind) 
+	  cand[n++] = inds[1];
+	else if(inds[1] == ind) 
+	  cand[n++] = inds[0];
       }
     }
-
     /* This sets all elemental connections */
     else {
       nonodes = data->elementtypes[i] % 100;
-      for(j=0;j<nonodes;j++) {
-	ind = data->topology[i][j];
-	for(k=0;k<nonodes;k++) {
-	  ind2 = data->topology[i][k];
-	  if(ind == ind2) continue;
-	  
-	  hit = FALSE;
-	  for(l=0;l<maxcon;l++) { 
-	    if(data->nodalgraph[l][ind] == ind2) hit = TRUE;
-	    if(data->nodalgraph[l][ind] == 0) break;
-	  }
-	  if(!hit) {
-	    if(l >= maxcon) {
-	      data->nodalgraph[maxcon] = Ivector(1,noknots);
-	      for(m=1;m<=noknots;m++)
-		data->nodalgraph[maxcon][m] = 0;
-	      maxcon++;
-	    }
-	    data->nodalgraph[l][ind] = ind2;
-	    totcon++;
-	  }
-	}
+      for(k=0;k<nonodes;k++) {
+	ind2 = data->topology[i][k];
+	if(ind2 != ind) cand[n++] = ind2;
       }
     }
-
   }
+  n = UniqueKeepFirst(cand,n,work);
 
-  /* This adds the periodic connections */
+  /* This adds the periodic connection */
+  *periodic = FALSE;
   if( data->periodicexist ) {
-    for(ind=1;ind<=noknots;ind++) {
-      ind2 = data->periodic[ind];      
-      if(ind == ind2) continue;
-
-      hit = FALSE;
-      for(l=0;l<maxcon;l++) { 
-	if(data->nodalgraph[l][ind] == ind2) hit = TRUE;
-	if(data->nodalgraph[l][ind] == 0) break;
-      }
-      if(!hit) {
-	if(l >= maxcon) {
-	  data->nodalgraph[maxcon] = Ivector(1,noknots);
-	  for(m=1;m<=noknots;m++)
-	    data->nodalgraph[maxcon][m] = 0;
-	  maxcon++;
-	}
-	data->nodalgraph[l][ind] = ind2;
-	totcon++;
-	percon++;
+    ind2 = data->periodic[ind];
+    if(ind2 != ind) {
+      for(k=0;k<n;k++)
+	if(cand[k] == ind2) break;
+      if(k == n) {
+	cand[n++] = ind2;
+	*periodic = TRUE;
       }
     }
   }
 
-  data->nodalmaxconnections = maxcon;
-  data->nodalexists = TRUE;
-  
-  if(info) {
-    printf("There are at maximum %d connections in nodal graph.\n",maxcon);
-    printf("There are at all in all %d connections in nodal graph.\n",totcon);
-    if(percon) printf("There are %d periodic connections in nodal graph.\n",percon);
-  }
-
-  return(0);
+  return(n);
 }
 
 
-int DestroyNodalGraph(struct FemType *data,int info)
+static int CreateInverseTopologyCRS(struct FemType *data,struct CRSType *invtopo,int info)
 {
-  int i,maxcon, noknots;
-  
-  if(!data->nodalexists) {
-    printf("You tried to destroy a non-existing nodal graph\n");
-    return(1);
-  }
-
-  maxcon = data->nodalmaxconnections;
-  noknots = data->noknots;
-
-  for(i=0;i<maxcon;i++)    
-    free_Ivector(data->nodalgraph[i],1,noknots);
-
-  data->nodalmaxconnections = 0;
-  data->nodalexists = FALSE; 
-
-  if(info) printf("The nodal graph was destroyed\n");
-  return(0);
-}
-
-
-
-int CreateInverseTopology(struct FemType *data,int info)
-{
-  int i,j,k,l,m,noelements,noknots,elemtype,nonodes,ind;
+  int i,j,k,noelements,noknots,nonodes,ind;
   int *neededby,minneeded,maxneeded;
   int step,totcon;
-  int *rows,*cols;
-  struct CRSType *invtopo;
-
-  invtopo = &data->invtopo;
-  if(invtopo->created) {
-    if(0) printf("The inverse topology already exists!\n");
-    return(0);
-  }
-
-  printf("Creating an inverse topology of the finite element mesh\n");  
+  int *rows=NULL,*cols=NULL;
 
   noelements = data->noelements;
   noknots = data->noknots;
@@ -9775,7 +9694,6 @@ int CreateInverseTopology(struct FemType *data,int info)
       neededby[i] = 0;
 
     for(i=1;i<=noelements;i++) {
-      elemtype = data->elementtypes[i];
       nonodes = data->elementtypes[i] % 100;
       
       for(j=0;j<nonodes;j++) {
@@ -9828,13 +9746,173 @@ int CreateInverseTopology(struct FemType *data,int info)
 }
 
 
+int CreateNodalGraph(struct FemType *data,int full,int info)
+/* The nodal graph is created in compressed row format. The rows are independent 
+   and are hence computed in parallel, first to count and then to fill them. 
+   The connections of a node are in the order they are met going through the elements. */
+{
+  int i,l,noknots,maxcon,totcon,percon,maxcand,step;
+  int *rows,*cols=NULL;
+  struct CRSType invtopo,*nodalgraph;
+
+  printf("Creating a nodal graph of the finite element mesh\n");  
+
+  if(data->nodalexists) {
+    printf("The nodal graph already exists!\n");
+    smallerror("Nodal graph not done");
+    return(1);
+  }
+
+  noknots = data->noknots;
+  nodalgraph = &data->nodalgraph;
+
+  /* A private inverse topology is used since the mesh may have been modified 
+     after the shared one was created. */
+  CreateInverseTopologyCRS(data,&invtopo,FALSE);
+
+  /* Upper limit for the candidate connections of a node */
+  maxcand = 1;
+  for(i=1;i<=noknots;i++) {
+    l = 0;
+    for(totcon=invtopo.rows[i-1];totcon<invtopo.rows[i];totcon++)
+      l += data->elementtypes[invtopo.cols[totcon]+1] % 100;
+    maxcand = MAX( maxcand, l+1 );
+  }
+
+  rows = Ivector(0,noknots);
+  rows[0] = 0;
+  percon = 0;
+
+  for(step=1;step<=2;step++) {
+#pragma omp parallel
+    {
+      int i,k,n,per,*cand;
+      long long *work;
+      
+      cand = Ivector(0,maxcand-1);
+      work = (long long*) malloc((size_t) maxcand*sizeof(long long));
+      if(!work) nrerror("allocation failure in CreateNodalGraph()");
+
+#pragma omp for schedule(dynamic,1024) reduction(+:percon)
+      for(i=1;i<=noknots;i++) {
+	n = NodalGraphRow(data,full,i,&invtopo,cand,work,&per);
+	if(step == 1) {
+	  rows[i] = n;
+	  if(per) percon++;
+	}
+	else {
+	  for(k=0;k<n;k++)
+	    cols[rows[i-1]+k] = cand[k]-1;
+	}
+      }
+      free_Ivector(cand,0,maxcand-1);
+      free(work);
+    }
+
+    if(step == 1) {
+      maxcon = 0;
+      for(i=1;i<=noknots;i++) {
+	maxcon = MAX( maxcon, rows[i] );
+	rows[i] += rows[i-1];
+      }
+      totcon = rows[noknots];
+      cols = Ivector(0,MAX(totcon,1)-1);
+    }
+  }
+
+  DestroyCRSMatrix(&invtopo);
+
+  nodalgraph->rows = rows;
+  nodalgraph->cols = cols;
+  nodalgraph->rowsize = noknots;
+  nodalgraph->colsize = MAX(totcon,1);
+  nodalgraph->created = TRUE;
+
+  data->nodalmaxconnections = maxcon;
+  data->nodalexists = TRUE;
+  
+  if(info) {
+    printf("There are at maximum %d connections in nodal graph.\n",maxcon);
+    printf("There are at all in all %d connections in nodal graph.\n",totcon);
+    if(percon) printf("There are %d periodic connections in nodal graph.\n",percon);
+  }
+
+  return(0);
+}
+
+
+int DestroyNodalGraph(struct FemType *data,int info)
+{
+  if(!data->nodalexists) {
+    printf("You tried to destroy a non-existing nodal graph\n");
+    return(1);
+  }
+
+  DestroyCRSMatrix( &data->nodalgraph );
+
+  data->nodalmaxconnections = 0;
+  data->nodalexists = FALSE; 
+
+  if(info) printf("The nodal graph was destroyed\n");
+  return(0);
+}
+
+
+
+int CreateInverseTopology(struct FemType *data,int info)
+{
+  struct CRSType *invtopo;
+
+  invtopo = &data->invtopo;
+  if(invtopo->created) {
+    if(0) printf("The inverse topology already exists!\n");
+    return(0);
+  }
+
+  printf("Creating an inverse topology of the finite element mesh\n");  
+
+  return( CreateInverseTopologyCRS(data,invtopo,info) );
+}
+
+
+
+static int DualGraphRow(struct FemType *data,int elem,int *elemconnect,int *invrow,int *invcol,
+			int *cand,long long *work)
+/* Elements sharing a node with element elem, in the order they are met. */
+{
+  int j,k,n,nonodes,ind,i2,ci2;
+
+  n = 0;
+  nonodes = data->elementtypes[elem] % 100;
+  for(j=0;j<nonodes;j++) {
+    ind = data->topology[elem][j];
+    for(k=invrow[ind-1];k<invrow[ind];k++) {
+      i2 = invcol[k]+1;
+      if( i2 == elem ) continue;
+	  
+      if( elemconnect ) {
+	ci2 = elemconnect[i2];
+	if( ci2 < 0 ) continue;
+      }
+      else {
+	ci2 = i2;
+      }
+      cand[n++] = ci2;
+    }
+  }
+
+  return( UniqueKeepFirst(cand,n,work) );
+}
+
 
 int CreateDualGraph(struct FemType *data,int unconnected,int info)
+/* The dual graph is created in compressed row format. As with the nodal graph
+   the rows are counted and filled in parallel. */
 {
-  int totcon,dcon,noelements,noknots,elemtype,nonodes,i,j,k,l,i2,m,ind,hit,ci,ci2;
-  int dualmaxcon,invmaxcon,showgraph,freeelements,step,orphanelements;
-  int *elemconnect,*neededby;
-  int *dualrow,*dualcol,dualsize,dualmaxelem,allocated;
+  int totcon,noelements,noknots,i,j,step,orphanelements;
+  int dualmaxcon,dualmaxelem,freeelements,maxnodes,maxinv,maxcand;
+  int *elemconnect;
+  int *dualrow,*dualcol=NULL,dualsize;
   int *invrow,*invcol;
   struct CRSType *dualgraph;
 
@@ -9851,7 +9929,7 @@ int CreateDualGraph(struct FemType *data,int unconnected,int info)
   noelements = data->noelements;
   noknots = data->noknots;
   freeelements = noelements;
-  orphanelements = 0;
+  elemconnect = NULL;
   
   /* If a dual graph only for the unconnected nodes is requested do that.
      Basically the connected nodes are omitted in the graph. */
@@ -9871,153 +9949,98 @@ int CreateDualGraph(struct FemType *data,int unconnected,int info)
     if(info) printf("List of unconnected elements created\n");
   }
 
-  showgraph = FALSE;
-  if(showgraph) printf("elemental graph ij pairs\n");
-
   data->dualexists = TRUE;
-  dualmaxcon = 0;
-  dualmaxelem = 0;
  
   invrow = data->invtopo.rows;
   invcol = data->invtopo.cols;
 
+  /* Upper limit for the candidate connections of an element */
+  maxinv = 0;
+  for(i=1;i<=noknots;i++)
+    maxinv = MAX( maxinv, invrow[i]-invrow[i-1] );
+  maxnodes = 0;
+  for(i=1;i<=noelements;i++)
+    maxnodes = MAX( maxnodes, data->elementtypes[i] % 100 );
+  maxcand = MAX( 1, maxnodes * maxinv );
 
-  /* This marker is used to identify the connections already accounted for */  
-  neededby = Ivector(1,freeelements);
-  for(i=1;i<=freeelements;i++)
-    neededby[i] = 0;
+  dualsize = freeelements;
+  dualrow = Ivector(0,dualsize);
+  for(i=0;i<=dualsize;i++) 
+    dualrow[i] = 0;
 
-  allocated = FALSE;
- omstart: 
+  for(step=1;step<=2;step++) {
+#pragma omp parallel 
+    {
+      int i,k,n,ci,*cand;
+      long long *work;
+      
+      cand = Ivector(0,maxcand-1);
+      work = (long long*) malloc((size_t) maxcand*sizeof(long long));
+      if(!work) nrerror("allocation failure in CreateDualGraph()");
 
-  totcon = 0;
+#pragma omp for schedule(dynamic,1024)
+      for(i=1;i<=noelements;i++) {
+	if( unconnected ) {
+	  ci = elemconnect[i];
+	  if( ci < 0 ) continue;
+	}
+	else {
+	  ci = i;
+	}      
+	n = DualGraphRow(data,i,elemconnect,invrow,invcol,cand,work);
+	if(step == 1) 
+	  dualrow[ci] = n;
+	else 
+	  for(k=0;k<n;k++)
+	    dualcol[dualrow[ci-1]+k] = cand[k]-1;
+      }
+      free_Ivector(cand,0,maxcand-1);
+      free(work);
+    }
 
-  for(i=1;i<=noelements;i++) {
-    if(showgraph) printf("%d :: ",i);
+    if(step == 1) {
+      for(i=1;i<=dualsize;i++) 
+	dualrow[i] += dualrow[i-1];
+      totcon = dualrow[dualsize];
+      dualcol = Ivector(0,MAX(totcon,1)-1);
+    }
+  }
 
-    dcon = 0;
-    elemtype = data->elementtypes[i];    
-    nonodes = data->elementtypes[i] % 100;
+  dualgraph->cols = dualcol;
+  dualgraph->rows = dualrow;
+  dualgraph->rowsize = dualsize;
+  dualgraph->colsize = MAX(totcon,1);
+  dualgraph->created = TRUE;
 
+  dualmaxcon = 0;
+  dualmaxelem = 0;
+  orphanelements = 0;
+  for(i=1;i<=noelements;i++) {
     if( unconnected ) {
-      ci = elemconnect[i];
-      if( ci < 0 ) continue;
+      j = elemconnect[i];
+      if( j < 0 ) continue;
     }
     else {
-      ci = i;
-    }      
-    if(allocated) dualrow[ci-1] = totcon;
-
-    if(0) printf("i=%d %d\n",i,elemtype);
-
-    for(step=1;step<=2;step++) {
-      for(j=0;j<nonodes;j++) {
-	ind = data->topology[i][j];
-	
-	if(0) printf("ind=%d\n",ind);
-
-
-	for(k=invrow[ind-1];k<invrow[ind];k++) {
-	  i2 = invcol[k]+1;
-	  
-	  if( i2 == i ) continue;
-	  
-	  if( unconnected ) {
-	    ci2 = elemconnect[i2];
-	    if( ci2 < 0 ) continue;
-	  }
-	  else {
-	    ci2 = i2;
-	  }
-
-	  /* In the first cycle mark the needed connections,
-	     and in the second cycle set the marker to zero for next round. */
-	  if( step == 1 ) {
-	    if( neededby[ci2] ) continue;
-	    neededby[ci2] = TRUE;
-
-	    if(0) printf("ci ci2 = %d %d\n",ci,ci2);
-
-	    /* If the dual graph has been allocated populate it */
-	    if(allocated) {	      
-	      dualcol[totcon] = ci2-1;
-	    }
-
-	    dcon += 1;
-	    totcon += 1;
-	    if( dcon > dualmaxcon ) {
-	      dualmaxcon = dcon;
-	      dualmaxelem = i;
-	    }
-	  }
-	  else {
-	    neededby[ci2] = FALSE;
-	  }
-	}
-      }
+      j = i;
     }
-    if( dcon == 0 && allocated ) {
-      orphanelements += 1;
+    if( dualrow[j]-dualrow[j-1] > dualmaxcon ) {
+      dualmaxcon = dualrow[j]-dualrow[j-1];
+      dualmaxelem = i;
     }
-  }	
-
-  if(allocated) {
-    dualrow[dualsize] = totcon;
+    if( dualrow[j] == dualrow[j-1] ) orphanelements += 1;
   }
-  else {
-    dualsize = freeelements;
-    dualrow = Ivector(0,dualsize);
-    for(i=1;i<=dualsize;i++) 
-      dualrow[i] = 0;
-
-    dualcol = Ivector(0,totcon-1);
-    for(i=0;i<totcon;i++) 
-      dualcol[i] = 0;
-
-    dualgraph->cols = dualcol;
-    dualgraph->rows = dualrow;
-    dualgraph->rowsize = dualsize;
-    dualgraph->colsize = totcon;
-    dualgraph->created = TRUE;
-
-    allocated = TRUE;
-
-    goto omstart;
-  } 
 
   if( orphanelements ) {
     printf("There are %d elements in the dual mesh that are not connected!\n",orphanelements);
     if(unconnected) printf("The orphan elements are likely caused by the hybrid partitioning\n");
   }
 
-
-#if 0
-  j = totcon; k = 0;
-  for(i=1;i<=dualsize;i++){
-    l = dualrow[i]-dualrow[i-1];
-    if(l <= 0 ) printf("row(%d) = %d %d %d\n",i,l,dualrow[i],dualrow[i-1]);
-    j = MIN(j,l);
-    k = MAX(k,l);
-  }
-  printf("range dualrow: %d %d\n",j,k);
-
-  j = totcon; k = 0;
-  for(i=0;i<totcon;i++) {
-    j = MIN(j,dualcol[i]);
-    k = MAX(k,dualcol[i]);
-  }
-  printf("range dualcol: %d %d\n",j,k);
-#endif
-
-
   if(info) {
     printf("There are at maximum %d connections in dual graph (in element %d).\n",dualmaxcon,dualmaxelem);
     printf("There are at all in all %d connections in dual graph.\n",totcon);
     printf("Average connection per active element in dual graph is %.3f\n",1.0*totcon/freeelements);
   }  
 
-  free_Ivector( neededby,1,freeelements);
-
   /* Inverse topology is created for partitioning only and then the direct
      topology is needed elsewhere as well. Do do not destroy it. */ 
   if(0) DestroyInverseTopology(data,info);
@@ -10028,7 +10051,7 @@ int CreateDualGraph(struct FemType *data,int unconnected,int info)
 
 int DestroyCRSMatrix(struct CRSType *sp) {
 
-  if(sp->created) {
+  if(!sp->created) {
     if(0) printf("You tried to destroy a non-existing sparse matrix\n");
     return(1);
   }
@@ -10045,17 +10068,15 @@ int DestroyCRSMatrix(struct CRSType *sp) {
 
 int DestroyInverseTopology(struct FemType *data,int info)
 {
-  DestroyCRSMatrix( &data->invtopo );
+  return( DestroyCRSMatrix( &data->invtopo ) );
 }
 
 int DestroyDualGraph(struct FemType *data,int info)
 {
-  DestroyCRSMatrix( &data->dualgraph );
+  data->dualexists = FALSE;
+  return( DestroyCRSMatrix( &data->dualgraph ) );
 }
 
-
-
-
 int MeshTypeStatistics(struct FemType *data,int info)
 {
   int i,elemtype,maxelemtype,minelemtype;
@@ -111,4 +111,5 @@ int CreateDualGraph(struct FemType *data,int unconnected,int info);
 int DestroyDualGraph(struct FemType *data,int info);
 int CreateInverseTopology(struct FemType *data,int info);
 int DestroyInverseTopology(struct FemType *data,int info);
+int DestroyCRSMatrix(struct CRSType *sp);
 int MeshTypeStatistics(struct FemType *data,int info);
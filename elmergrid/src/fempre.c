@@ -165,6 +165,7 @@ static void Instructions()
   printf("-nonames             : disable use of mesh.names even if it would be supported by the format\n");
   printf("-nosave              : disable saving part alltogether\n");
   printf("-nooverwrite         : if mesh already exists don't overwite it\n");
+  printf("-binary              : save ElmerSolver mesh also in binary format for fast loading\n");
   printf("-vtuone              : start real node indexes in vtu file from one\n");
   printf("-timer               : show timer information\n");
   printf("-infofile str        : file for saving the timer and size information\n");
@@ -1018,12 +1019,18 @@ int main(int argc, char *argv[])
 
   case 2:
     for(k=0;k<nomeshes;k++) {
-      if(data[k].nopartitions > 1) 
+      if(data[k].nopartitions > 1) {
 	SaveElmerInputPartitioned(&data[k],boundaries[k],eg.filesout[k],eg.decimals,
 				  eg.partitionhalo,eg.partitionindirect,eg.parthypre,
 				  MAX(eg.partbcz,eg.partbcr),eg.nooverwrite,info);
-      else
+	if(eg.binarymesh) 
+	  SaveElmerInputBinaryPartitioned(eg.filesout[k],data[k].nopartitions,info);
+      }
+      else {
 	SaveElmerInput(&data[k],boundaries[k],eg.filesout[k],eg.decimals,eg.nooverwrite,info);
+	if(eg.binarymesh) 
+	  SaveElmerInputBinary(eg.filesout[k],info);
+      }
     }
     break;
 
@@ -20,7 +20,7 @@
 #define MAXCONNECTIONS 500  /* maximum number of connections in nodal or dual graph */
 #define MAXBCS 1000         /* maximum number of BCs in naming */
 #define MAXBODIES 1000      /* maximum number of bodies in naming */
-#define MAXPARTITIONS 512   /* maximum number of partitions */
+#define MAXPARTITIONS 512   /* default number of partition files handled at a time */
 
 #define CONPLAIN 0
 #define CONDISCONT 1
@@ -182,7 +182,6 @@ struct FemType {
     variables,     /* number of variables */
     indexwidth,    /* maximum difference of node indices */
     mapgeo,        /* mappings for geometry */
-    *nodalgraph[MAXCONNECTIONS],  
     nodalmaxconnections,
     nodalexists,
     dualexists,
@@ -230,7 +229,7 @@ struct FemType {
       boundtype[MAXBOUNDARIES];  /* type of the boundary */
 
   struct CRSType dualgraph,      /* The dual graph of the finite element mesh */
-    nodalgraph2,                  /* The nodal graph of the finite element mesh */
+    nodalgraph,                   /* The nodal graph of the finite element mesh */
     invtopo;                      /* The inverse of the finite element mesh topology */
 };
 
@@ -380,7 +379,8 @@ struct ElmergridType {
     rotatecurve,
     timeron,
     nosave,
-    nooverwrite;
+    nooverwrite,
+    binarymesh; /* save the ElmerSolver mesh also in binary format */
 
   Real cscale[3], 
     corder[3],
@@ -113,3 +113,275 @@ double FC_FUNC(cpumemory,CPUMEMORY) ()
 #endif /* USE_ISO_C_BINDINGS*/
 
 #endif // WIN32
+
+
+/*
+ * Hierarchical profiling of named regions of code. The regions are nested 
+ * and form a tree where a region is identified by its name and the region 
+ * it was started in. For each region the number of calls, the total and 
+ * self time (excluding the subregions) are accumulated. Optionally each 
+ * call is recorded as an event that may be written as a Chrome trace. 
+ *
+ * Regions are only recorded outside of OpenMP parallel regions. Stopping a 
+ * region also stops the regions started within it and left open.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PROFILER_NAMELEN 64
+#define PROFILER_MAXDEPTH 64
+
+typedef struct {
+  char name[PROFILER_NAMELEN];
+  int parent, child, sibling, depth;
+  long calls;
+  double t0, total, children, tmin, tmax;
+} profiler_region_t;
+
+typedef struct {
+  int region;
+  double t0, t1;
+} profiler_event_t;
+
+static profiler_region_t *prof_regions = NULL;
+static int prof_nregions = 0, prof_maxregions = 0;
+static int prof_stack[PROFILER_MAXDEPTH], prof_depth = 0, prof_overflow = 0;
+static int prof_active = 0;
+
+static profiler_event_t *prof_events = NULL;
+static long prof_nevents = 0, prof_maxevents = 0, prof_dropped = 0;
+
+static double profiler_clock()
+{
+#if defined(MINGW32) || defined(WIN32)
+  return clock() / (double)CLOCKS_PER_SEC;
+#else
+  struct timeval t;
+  gettimeofday( &t, NULL );
+  return (double) t.tv_sec + t.tv_usec*1.0e-6;
+#endif
+}
+
+static int profiler_serial()
+{
+#ifdef _OPENMP
+  return !omp_in_parallel();
+#else
+  return 1;
+#endif
+}
+
+/* Activate the profiler, with room for maxevents trace events if trace is set. */
+void STDCALLBULL profiler_init( int *active, int *trace, int *maxevents )
+{
+  prof_active = *active;
+  if ( !prof_active ) return;
+
+  if ( !prof_regions ) {
+    prof_maxregions = 256;
+    prof_regions = (profiler_region_t *) calloc( prof_maxregions, sizeof(profiler_region_t) );
+    /* The root region is never timed */
+    strcpy( prof_regions[0].name, "root" );
+    prof_regions[0].parent = prof_regions[0].child = prof_regions[0].sibling = -1;
+    prof_nregions = 1;
+    prof_stack[0] = 0;
+    prof_depth = 0;
+  }
+
+  if ( *trace && *maxevents > 0 && !prof_events ) {
+    prof_maxevents = *maxevents;
+    prof_events = (profiler_event_t *) malloc( prof_maxevents * sizeof(profiler_event_t) );
+    if ( !prof_events ) prof_maxevents = 0;
+  }
+}
+
+void STDCALLBULL profiler_start( char *name, int *len )
+{
+  int n, r, p;
+  profiler_region_t *reg;
+
+  if ( !prof_active || !profiler_serial() ) return;
+
+  if ( prof_depth >= PROFILER_MAXDEPTH-1 ) {
+    prof_overflow++;
+    return;
+  }
+
+  n = *len < PROFILER_NAMELEN ? *len : PROFILER_NAMELEN-1;
+  p = prof_stack[prof_depth];
+
+  for( r = prof_regions[p].child; r >= 0; r = prof_regions[r].sibling ) 
+    if ( !strncmp( prof_regions[r].name, name, n ) && prof_regions[r].name[n] == '\0' ) break;
+
+  if ( r < 0 ) {
+    if ( prof_nregions >= prof_maxregions ) {
+      prof_maxregions *= 2;
+      prof_regions = (profiler_region_t *) realloc( prof_regions, 
+                        prof_maxregions * sizeof(profiler_region_t) );
+    }
+    r = prof_nregions++;
+    reg = &prof_regions[r];
+    memset( reg, 0, sizeof(profiler_region_t) );
+    strncpy( reg->name, name, n );
+    reg->name[n] = '\0';
+    reg->parent = p;
+    reg->depth = prof_depth+1;
+    reg->sibling = -1;
+    reg->child = -1;
+    reg->tmin = 1.0e30;
+
+    /* Keep the subregions in the order they were first met */
+    if ( prof_regions[p].child < 0 ) {
+      prof_regions[p].child = r;
+    } else {
+      int s = prof_regions[p].child;
+      while ( prof_regions[s].sibling >= 0 ) s = prof_regions[s].sibling;
+      prof_regions[s].sibling = r;
+    }
+  }
+
+  prof_stack[++prof_depth] = r;
+  prof_regions[r].t0 = profiler_clock();
+}
+
+/* Stop the innermost open region of the name and any regions left open within it. 
+   With innermost set only the innermost open region is stopped if it is of the name. */
+void STDCALLBULL profiler_stop( char *name, int *len, int *innermost )
+{
+  int d, n, r;
+  double t, dt;
+  profiler_region_t *reg;
+
+  if ( !prof_active || !profiler_serial() ) return;
+
+  if ( prof_overflow > 0 ) {
+    prof_overflow--;
+    return;
+  }
+
+  /* Find the open region of the name, stops without a start are ignored */
+  n = *len < PROFILER_NAMELEN ? *len : PROFILER_NAMELEN-1;
+  for( d = prof_depth; d > 0; d-- ) {
+    reg = &prof_regions[prof_stack[d]];
+    if ( !strncmp( reg->name, name, n ) && reg->name[n] == '\0' ) break;
+    if ( *innermost ) { d = 0; break; }
+  }
+  if ( d == 0 ) return;
+
+  t = profiler_clock();
+  while ( prof_depth >= d ) {
+    r = prof_stack[prof_depth--];
+    reg = &prof_regions[r];
+    dt = t - reg->t0;
+    reg->calls++;
+    reg->total += dt;
+    if ( dt < reg->tmin ) reg->tmin = dt;
+    if ( dt > reg->tmax ) reg->tmax = dt;
+    prof_regions[reg->parent].children += dt;
+
+    if ( prof_maxevents > 0 ) {
+      if ( prof_nevents < prof_maxevents ) {
+        prof_events[prof_nevents].region = r;
+        prof_events[prof_nevents].t0 = reg->t0;
+        prof_events[prof_nevents].t1 = t;
+        prof_nevents++;
+      } else {
+        prof_dropped++;
+      }
+    }
+  }
+}
+
+/* Number of the recorded regions, the root excluded. */
+int STDCALLBULL profiler_regions()
+{
+  return prof_nregions > 0 ? prof_nregions-1 : 0;
+}
+
+/* Statistics of the i:th region in depth first order, i=1,...,profiler_regions(). 
+   The path is the names of the regions from the outermost one separated by '/'.
+   The values are the calls, total time, self time, and min and max time of a call. */
+void STDCALLBULL profiler_region( int *i, char *path, int *pathlen, int *depth, double *vals )
+{
+  int k, r, len, n, stack[PROFILER_MAXDEPTH];
+  profiler_region_t *reg;
+
+  /* Walk the tree in depth first order */
+  r = prof_regions[0].child;
+  for( k = 1; k < *i && r > 0; k++ ) {
+    if ( prof_regions[r].child > 0 ) {
+      r = prof_regions[r].child;
+    } else {
+      while ( r > 0 && prof_regions[r].sibling < 0 ) r = prof_regions[r].parent;
+      if ( r > 0 ) r = prof_regions[r].sibling;
+    }
+  }
+
+  *depth = 0;
+  if ( r <= 0 ) {
+    *pathlen = 0;
+    return;
+  }
+  reg = &prof_regions[r];
+
+  for( n = 0, k = r; k > 0 && n < PROFILER_MAXDEPTH; k = prof_regions[k].parent ) stack[n++] = k;
+
+  len = 0;
+  for( k = n-1; k >= 0; k-- ) {
+    char *s = prof_regions[stack[k]].name;
+    int m = strlen(s);
+    if ( len + m + 1 > *pathlen ) break;
+    if ( len > 0 ) path[len++] = '/';
+    memcpy( path+len, s, m );
+    len += m;
+  }
+  *pathlen = len;
+  *depth = reg->depth;
+
+  vals[0] = reg->calls;
+  vals[1] = reg->total;
+  vals[2] = reg->total - reg->children;
+  vals[3] = reg->calls > 0 ? reg->tmin : 0.0;
+  vals[4] = reg->tmax;
+}
+
+/* Write the recorded events in Chrome trace event format, with the rank as process id. */
+void STDCALLBULL profiler_write_trace( char *file, int *len, int *rank )
+{
+  char name[1024];
+  FILE *fp;
+  long i;
+  int n;
+  const char *s;
+
+  n = *len < 1023 ? *len : 1023;
+  strncpy( name, file, n );
+  name[n] = '\0';
+
+  fp = fopen( name, "w" );
+  if ( !fp ) {
+    fprintf( stderr, "profiler_write_trace: Could not open file %s\n", name );
+    return;
+  }
+
+  fprintf( fp, "{\"traceEvents\":[\n" );
+  fprintf( fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Partition %d\"}}", 
+      *rank, *rank );
+  for( i = 0; i < prof_nevents; i++ ) {
+    fprintf( fp, ",\n{\"name\":\"" );
+    for( s = prof_regions[prof_events[i].region].name; *s; s++ ) {
+      if ( *s == '"' || *s == '\\' ) fputc( '\\', fp );
+      fputc( *s, fp );
+    }
+    fprintf( fp, "\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":%d,\"tid\":0}", 
+        prof_events[i].t0*1.0e6, (prof_events[i].t1-prof_events[i].t0)*1.0e6, *rank );
+  }
+  fprintf( fp, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%ld}}\n", 
+      prof_dropped );
+  fclose( fp );
+}
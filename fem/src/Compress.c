@@ -0,0 +1,119 @@
+/*****************************************************************************
+! *
+! *  Elmer, A Finite Element Software for Multiphysical Problems
+! *
+! *  Copyright 1st April 1995 - , CSC - IT Center for Science Ltd., Finland
+! *
+! *  This library is free software; you can redistribute it and/or
+! *  modify it under the terms of the GNU Lesser General Public
+! *  License as published by the Free Software Foundation; either
+! *  version 2.1 of the License, or (at your option) any later version.
+! *
+! *  This library is distributed in the hope that it will be useful,
+! *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+! *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+! *  Lesser General Public License for more details.
+! *
+! *  You should have received a copy of the GNU Lesser General Public
+! *  License along with this library (in file ../LGPL-2.1); if not, write
+! *  to the Free Software Foundation, Inc., 51 Franklin Street,
+! *  Fifth Floor, Boston, MA  02110-1301  USA
+! *
+! *****************************************************************************
+!
+! ******************************************************************************
+! *
+! * Blockwise zlib compression of binary output data. The data is split into
+! * blocks of fixed size that are compressed independently, as expected by
+! * the vtkZLibDataCompressor of the VTK XML formats. Independent blocks may
+! * be compressed concurrently by OpenMP threads.
+! *
+! * If Elmer has been compiled without zlib the routines report failure and
+! * the caller should revert to uncompressed output.
+! *
+! ******************************************************************************/
+
+#include "../config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+
+/* Returns 1 if the compression is available, 0 otherwise. */
+int elmer_compress_available()
+{
+#ifdef HAVE_ZLIB
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+
+/* Size of the work space needed for compressing 'nbytes' bytes
+   in blocks of 'blocksize' bytes. Returns -1 if it does not fit in an int. */
+int elmer_compress_bound(int nbytes, int blocksize)
+{
+#ifdef HAVE_ZLIB
+  size_t nblocks, bound;
+  if( blocksize <= 0 || nbytes < 0 ) return -1;
+  nblocks = ((size_t)nbytes + blocksize - 1) / blocksize;
+  bound = nblocks * (size_t)compressBound( (uLong)blocksize );
+  if( bound > INT_MAX ) return -1;
+  return (int)bound;
+#else
+  return -1;
+#endif
+}
+
+
+/* Compresses 'nbytes' bytes from 'src' in blocks of 'blocksize' bytes into
+   'dst' which has room for 'dstsize' bytes, see elmer_compress_bound. The
+   compressed blocks are packed one after another and the size of each is
+   returned in 'compsizes'. Returns the total size of the compressed data or
+   a negative value in case of failure. */
+int elmer_compress_blocks(const char *src, int nbytes, int blocksize, int level,
+			  char *dst, int dstsize, int *compsizes)
+{
+#ifdef HAVE_ZLIB
+  int i, nblocks, fail;
+  size_t slot, total;
+
+  if( blocksize <= 0 || nbytes < 0 ) return -1;
+  nblocks = (int)(((size_t)nbytes + blocksize - 1) / blocksize);
+  slot = (size_t)compressBound( (uLong)blocksize );
+  if( (size_t)nblocks * slot > (size_t)dstsize ) return -1;
+
+  /* Each block is first compressed into a slot of its own so that the
+     blocks are independent of each other. */
+  fail = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:fail)
+  for(i=0; i<nblocks; i++) {
+    uLongf complen = (uLongf)slot;
+    int n = (i < nblocks-1) ? blocksize : (int)((size_t)nbytes - (size_t)i*blocksize);
+    if( compress2( (Bytef*)dst + (size_t)i*slot, &complen,
+		   (const Bytef*)src + (size_t)i*blocksize, (uLong)n, level ) != Z_OK ) {
+      fail++;
+      complen = 0;
+    }
+    compsizes[i] = (int)complen;
+  }
+  if( fail ) return -1;
+
+  /* Pack the compressed blocks */
+  total = 0;
+  for(i=0; i<nblocks; i++) {
+    if( total != (size_t)i*slot )
+      memmove( dst + total, dst + (size_t)i*slot, compsizes[i] );
+    total += compsizes[i];
+  }
+  return (int)total;
+#else
+  return -1;
+#endif
+}
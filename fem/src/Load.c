@@ -590,6 +590,26 @@ int STDCALLBULL FC_FUNC(execlinsolveprocs,EXECLINSOLVEPROCS)
 
 char *mtc_domath(char *);
 void mtc_init(FILE *,FILE *, FILE *);
+void *mtc_compile(char *);
+void mtc_setvar(char *, double *, int);
+int mtc_evalcode(void *, double *, char **);
+
+/*--------------------------------------------------------------------------
+  INTERNAL: initialize matc for the calling thread
+  -------------------------------------------------------------------------*/
+static void matc_initialize()
+{
+  static int been_here = 0;
+  char cc[32];
+#pragma omp threadprivate(been_here)
+
+   if ( been_here==0 ) {
+     mtc_init( NULL, stdout, stderr ); 
+     strcpy( cc, "format( 12,\"rowform\")" );
+     mtc_domath( cc );
+     been_here = 1;
+   }
+}
 
 /*--------------------------------------------------------------------------
   This routine will call matc and return matc variable array values
@@ -615,21 +635,14 @@ void STDCALLBULL FC_FUNC(matc,MATC) ( char *cmd, char *Value, int *len )
 {
 #define MAXLEN 8192
 
-  static int been_here = 0;
-  char *ptr, c, cc[32];
+  char *ptr, c;
   int slen, start;
-#pragma omp threadprivate(been_here)
 
   /* MB: Critical section removed since Matc library
    * modified to be thread safe */
 
    slen = *len;
-   if ( been_here==0 ) {
-     mtc_init( NULL, stdout, stderr ); 
-     strcpy( cc, "format( 12,\"rowform\")" );
-     mtc_domath( cc );
-     been_here = 1;
-   }
+   matc_initialize();
 
   c = cmd[slen];
   cmd[slen] = '\0';
@@ -660,6 +673,99 @@ void STDCALLBULL FC_FUNC(matc,MATC) ( char *cmd, char *Value, int *len )
   cmd[slen]=c;
   }
 
+/*--------------------------------------------------------------------------
+  Compiled matc expressions, shared by all threads. Each distinct string
+  is compiled only once and the code is kept for the whole run.
+  -------------------------------------------------------------------------*/
+typedef struct matc_code_s {
+  struct matc_code_s *next;
+  char *cmd;
+  void *code;
+} matc_code_t;
+
+static matc_code_t *matc_codes = NULL;
+
+/*--------------------------------------------------------------------------
+  This routine will compile a matc expression for matc_evalcode. Returns
+  NULL if the expression cannot be compiled, then matc should be used.
+  Otherwise the handle refers to the entry of the string, which is needed
+  for reporting errors.
+  -------------------------------------------------------------------------*/
+#ifdef USE_ISO_C_BINDINGS
+void *STDCALLBULL matc_compile( char *cmd, int *len )
+#else
+void *STDCALLBULL FC_FUNC_(matc_compile,MATC_COMPILE) ( char *cmd, int *len )
+#endif
+{
+  matc_code_t *p;
+  char *str;
+  int start;
+  if ( *len <= 0 ) return NULL;
+
+  str = (char *)malloc( *len+1 );
+  strncpy( str, cmd, *len );
+  str[*len] = '\0';
+
+  start = 0;
+  if (strncmp(str,"nc:",3)==0) start=3;
+
+  matc_initialize();
+
+#pragma omp critical(matc_codes)
+  {
+    for( p=matc_codes; p; p=p->next )
+      if ( strcmp(p->cmd,str)==0 ) break;
+
+    if ( p ) {
+      free( str );
+    } else {
+      p = (matc_code_t *)malloc( sizeof(matc_code_t) );
+      p->cmd  = str;
+      p->code = mtc_compile( &str[start] );
+      p->next = matc_codes;
+      matc_codes = p;
+    }
+  }
+  return p->code ? p : NULL;
+}
+
+/*--------------------------------------------------------------------------
+  This routine will evaluate a compiled matc expression at npts points.
+  Variable st is set to the time and tx to the ntx values of each point,
+  given in the columns of tx (leading dimension ld). Returns zero if some
+  point gave no value, then matc should be used. MATC errors are reported
+  here as in matc, so that the expression is not evaluated again.
+  -------------------------------------------------------------------------*/
+#ifdef USE_ISO_C_BINDINGS
+int STDCALLBULL matc_evalcode( void **code, double *st, int *ntx, int *ld,
+                               int *npts, double *tx, double *f )
+#else
+int STDCALLBULL FC_FUNC_(matc_evalcode,MATC_EVALCODE) ( void **code, double *st,
+               int *ntx, int *ld, int *npts, double *tx, double *f )
+#endif
+{
+  matc_code_t *p = (matc_code_t *)*code;
+  char *msg = NULL;
+  int i, stat;
+
+  if ( !p ) return 0;
+
+  matc_initialize();
+
+  mtc_setvar( "st", st, 1 );
+  for( i=0; i<*npts; i++ ) {
+    if ( *ntx>0 ) mtc_setvar( "tx", &tx[i * *ld], *ntx );
+    stat = mtc_evalcode( p->code, &f[i], &msg );
+    if ( stat < 0 && strncmp(p->cmd,"nc:",3)!=0 ) {
+      fprintf( stderr, "Solver input file error: %s\n", msg ? msg : "MATC ERROR" );
+      fprintf( stderr, "...offending input line: %s\n", p->cmd );
+      exit(0);
+    }
+    if ( stat <= 0 ) return 0;
+  }
+  return 1;
+}
+
 /*--------------------------------------------------------------------------
   INTERNAL: execute user material function
   -------------------------------------------------------------------------*/
@@ -215,6 +215,93 @@ void FC_FUNC(binreaddouble_c,BINREADDOUBLE_C)(const int *unit, double *a,
 }
 
 
+/* Write/read a whole array of n doubles with a single stdio call; this is
+ * what the restart files use for the value blocks of the fields.  */
+
+void FC_FUNC(binwritedoublearray_c,BINWRITEDOUBLEARRAY_C)(const int *unit,
+                                                        const double *a,
+                                                        const int *n,
+                                                        int *status)
+{
+    size_t s;
+
+    assert(units[*unit].fd);
+    if (*n <= 0) {
+        *status = 0;
+        return;
+    }
+    s = fwrite(a, 8, *n, units[*unit].fd);
+    *status = (s == (size_t)*n) ? 0 : errno;
+}
+
+
+void FC_FUNC(binreaddoublearray_c,BINREADDOUBLEARRAY_C)(const int *unit,
+                                                       double *a,
+                                                       const int *n,
+                                                       int *status)
+{
+    size_t r;
+    int i;
+
+    assert(units[*unit].fd);
+    if (*n <= 0) {
+        *status = 0;
+        return;
+    }
+
+    r = fread(a, 8, *n, units[*unit].fd);
+    if (r != (size_t)*n)
+        *status = (feof(units[*unit].fd)) ? -1 : errno;
+    else
+        *status = 0;
+
+    if (units[*unit].convert)
+        for (i = 0; i < *n; i++) swap_bytes(&a[i], 8);
+}
+
+
+void FC_FUNC(binwriteint4array_c,BINWRITEINT4ARRAY_C)(const int *unit,
+                                                    const uint32_t *a,
+                                                    const int *n,
+                                                    int *status)
+{
+    size_t s;
+
+    assert(units[*unit].fd);
+    if (*n <= 0) {
+        *status = 0;
+        return;
+    }
+    s = fwrite(a, 4, *n, units[*unit].fd);
+    *status = (s == (size_t)*n) ? 0 : errno;
+}
+
+
+void FC_FUNC(binreadint4array_c,BINREADINT4ARRAY_C)(const int *unit,
+                                                   uint32_t *a,
+                                                   const int *n,
+                                                   int *status)
+{
+    size_t r;
+    int i;
+
+    assert(units[*unit].fd);
+    if (*n <= 0) {
+        *status = 0;
+        return;
+    }
+
+    r = fread(a, 4, *n, units[*unit].fd);
+    if (r != (size_t)*n)
+        *status = (feof(units[*unit].fd)) ? -1 : errno;
+    else
+        *status = 0;
+
+    if (units[*unit].convert)
+        for (i = 0; i < *n; i++) swap_bytes(&a[i], 4);
+}
+
+
 void FC_FUNC(binwritestring_c,BINWRITESTRING_C)(const int *unit,
                                                const char *s,
                                                const int *s_len,
@@ -113,6 +113,30 @@ MODULE BinIO
             REAL(C_DOUBLE) :: a
         END SUBROUTINE BinWriteDouble_C
 
+        SUBROUTINE BinReadDoubleArray_C(unit, a, n, stat) BIND(C, NAME="binreaddoublearray_c")
+            USE, INTRINSIC :: ISO_C_BINDING
+            INTEGER(C_INT) :: unit, n, stat
+            REAL(C_DOUBLE) :: a(*)
+        END SUBROUTINE BinReadDoubleArray_C
+
+        SUBROUTINE BinWriteDoubleArray_C(unit, a, n, stat) BIND(C, NAME="binwritedoublearray_c")
+            USE, INTRINSIC :: ISO_C_BINDING
+            INTEGER(C_INT) :: unit, n, stat
+            REAL(C_DOUBLE) :: a(*)
+        END SUBROUTINE BinWriteDoubleArray_C
+
+        SUBROUTINE BinReadInt4Array_C(unit, a, n, stat) BIND(C, NAME="binreadint4array_c")
+            USE, INTRINSIC :: ISO_C_BINDING
+            INTEGER(C_INT) :: unit, n, stat
+            INTEGER(C_INT) :: a(*)
+        END SUBROUTINE BinReadInt4Array_C
+
+        SUBROUTINE BinWriteInt4Array_C(unit, a, n, stat) BIND(C, NAME="binwriteint4array_c")
+            USE, INTRINSIC :: ISO_C_BINDING
+            INTEGER(C_INT) :: unit, n, stat
+            INTEGER(C_INT) :: a(*)
+        END SUBROUTINE BinWriteInt4Array_C
+
         SUBROUTINE BinWriteString_C( Unit, s, len, Status ) BIND(C, NAME='binwritestring_c')
           USE, INTRINSIC :: ISO_C_BINDING
           CHARACTER(C_CHAR) :: s(*)
@@ -246,6 +270,52 @@ CONTAINS
     END SUBROUTINE BinReadDouble
 
 
+    ! Write/read 'n' doubles at once.
+    SUBROUTINE BinWriteDoubleArray( Unit, a, n, Status )
+        INTEGER, INTENT(IN) :: Unit, n
+        DOUBLE PRECISION, INTENT(IN) :: a(*)
+        INTEGER, OPTIONAL, INTENT(OUT) :: Status
+        INTEGER :: Status_
+
+        CALL BinWriteDoubleArray_C( Unit, a, n, Status_ )
+        CALL HandleStatus( Status, Status_, "BINIO: Error writing Double array" )
+    END SUBROUTINE BinWriteDoubleArray
+
+
+    SUBROUTINE BinReadDoubleArray( Unit, a, n, Status )
+        INTEGER, INTENT(IN) :: Unit, n
+        DOUBLE PRECISION, INTENT(OUT) :: a(*)
+        INTEGER, OPTIONAL, INTENT(OUT) :: Status
+        INTEGER :: Status_
+
+        CALL BinReadDoubleArray_C( Unit, a, n, Status_ )
+        CALL HandleStatus( Status, Status_, "BINIO: Error reading Double array" )
+    END SUBROUTINE BinReadDoubleArray
+
+
+    ! Write/read 'n' 4-byte integers at once.
+    SUBROUTINE BinWriteInt4Array( Unit, a, n, Status )
+        INTEGER, INTENT(IN) :: Unit, n
+        INTEGER(Int4_k), INTENT(IN) :: a(*)
+        INTEGER, OPTIONAL, INTENT(OUT) :: Status
+        INTEGER :: Status_
+
+        CALL BinWriteInt4Array_C( Unit, a, n, Status_ )
+        CALL HandleStatus( Status, Status_, "BINIO: Error writing Int4 array" )
+    END SUBROUTINE BinWriteInt4Array
+
+
+    SUBROUTINE BinReadInt4Array( Unit, a, n, Status )
+        INTEGER, INTENT(IN) :: Unit, n
+        INTEGER(Int4_k), INTENT(OUT) :: a(*)
+        INTEGER, OPTIONAL, INTENT(OUT) :: Status
+        INTEGER :: Status_
+
+        CALL BinReadInt4Array_C( Unit, a, n, Status_ )
+        CALL HandleStatus( Status, Status_, "BINIO: Error reading Int4 array" )
+    END SUBROUTINE BinReadInt4Array
+
+
     ! Write a CHARACTER(1).  (Note: to read a CHARACTER(1), with no '\0' at the
     ! end, just use BinReadString with a CHARACTER(1) as argument.
     SUBROUTINE BinWriteChar( UNIT, c, Status )
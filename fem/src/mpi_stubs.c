@@ -54,6 +54,7 @@ void STDCALLBULL FC_FUNC_(mpi_bsend,MPI_BSEND) (void *a, void *b, void *c, void
 void STDCALLBULL FC_FUNC_(mpi_null_delete_fn,MPI_NULL_DELETE_FN) () {}
 void STDCALLBULL FC_FUNC_(mpi_buffer_attach,MPI_BUFFER_ATTACH) ( void *buf, int *i, int *ierr ) {}
 void STDCALLBULL FC_FUNC_(mpi_allreduce,MPI_ALLREDUCE) () {}
+void STDCALLBULL FC_FUNC_(mpi_iallreduce,MPI_IALLREDUCE) () {}
 void STDCALLBULL FC_FUNC_(mpi_wtime,MPI_WTIME) () {}
 void STDCALLBULL FC_FUNC_(mpi_irecv,MPI_IRECV) () {}
 void STDCALLBULL FC_FUNC_(mpi_isend,MPI_ISEND) () {}
@@ -591,21 +591,21 @@ void BiCubicComputeViewFactors(Geometry_t *GA,Geometry_t *GB,int LevelA,int Leve
         Hit = N_Integ;
         for( i=0; i<N_Integ; i++ )
         {
-            U = drand48();
-            V = drand48();
+            U = ViewFactorRandom();
+            V = ViewFactorRandom();
 
             FX = BiCubicValue( U,V,AX );
             FY = BiCubicValue( U,V,AY );
             FZ = BiCubicValue( U,V,AZ );
 
-            U = drand48();
-            V = drand48();
+            U = ViewFactorRandom();
+            V = ViewFactorRandom();
 
             DX = BiCubicValue( U,V,BX ) - FX;
             DY = BiCubicValue( U,V,BY ) - FY;
             DZ = BiCubicValue( U,V,BZ ) - FZ;
 
-            Hit -= RayHitGeometry( FX,FY,FZ,DX,DY,DZ );
+            Hit -= RayHitGeometryPacket( FX,FY,FZ,DX,DY,DZ,i==N_Integ-1 );
         }
 
         if ( Hit == 0 ) return;
@@ -441,21 +441,21 @@ void BiLinearComputeViewFactors(Geometry_t *GA,Geometry_t *GB,int LevelA,int Lev
         Hit = Nrays;
         for( i=0; i<Nrays; i++ )
         {
-            U = drand48(); V = drand48();
+            U = ViewFactorRandom(); V = ViewFactorRandom();
 
             FX = BiLinearValue(U,V,X);
             FY = BiLinearValue(U,V,Y);
             FZ = BiLinearValue(U,V,Z);
 
-            U = drand48(); V = drand48();
+            U = ViewFactorRandom(); V = ViewFactorRandom();
             if ( GB->GeometryType == GEOMETRY_TRIANGLE )
-                while( U+V>1 ) { U=drand48(); V=drand48(); }
+                while( U+V>1 ) { U=ViewFactorRandom(); V=ViewFactorRandom(); }
 
             DX = FunctionValue( GB,U,V,0 ) - FX;
             DY = FunctionValue( GB,U,V,1 ) - FY;
             DZ = FunctionValue( GB,U,V,2 ) - FZ;
 
-            Hit -= RayHitGeometry( FX,FY,FZ,DX,DY,DZ );
+            Hit -= RayHitGeometryPacket( FX,FY,FZ,DX,DY,DZ,i==Nrays-1 );
         }
 
         if ( Hit == 0 ) return;
@@ -580,19 +580,19 @@ void BiQuadraticComputeViewFactors(Geometry_t *GA,Geometry_t *GB,int LevelA,int
         Hit = 16.0;
         for( i=0; i<16; i++ )
         {
-            U = drand48(); V = drand48();
+            U = ViewFactorRandom(); V = ViewFactorRandom();
 
             FX = BiQuadraticValue(U,V,AX);
             FY = BiQuadraticValue(U,V,AY);
             FZ = BiQuadraticValue(U,V,AZ);
 
-            U = drand48(); V = drand48();
+            U = ViewFactorRandom(); V = ViewFactorRandom();
 
             DX = BiQuadraticValue(U,V,BX) - FX;
             DY = BiQuadraticValue(U,V,BY) - FY;
             DZ = BiQuadraticValue(U,V,BZ) - FZ;
 
-            Hit -= RayHitGeometry( FX,FY,FZ,DX,DY,DZ );
+            Hit -= RayHitGeometryPacket( FX,FY,FZ,DX,DY,DZ,i==15 );
         }
 
         if ( Hit == 0 ) return;
@@ -414,21 +414,21 @@ void LinearComputeViewFactors(Geometry_t *GA,Geometry_t *GB,int LevelA,int Level
        Hit = Nrays;
        for( i=0; i<Nrays; i++ )
        {
-          U = drand48(); V = drand48();
+          U = ViewFactorRandom(); V = ViewFactorRandom();
 
           FX = LinearValue(U,X);
           FY = LinearValue(U,Y);
           FZ = 0.0;
 
-           U = drand48(); V = drand48();
+           U = ViewFactorRandom(); V = ViewFactorRandom();
            if ( GB->GeometryType == GEOMETRY_TRIANGLE )
-               while( U+V>1 ) { U=drand48(); V=drand48(); }
+               while( U+V>1 ) { U=ViewFactorRandom(); V=ViewFactorRandom(); }
 
            DX = FunctionValue(GB,U,V,0)-FX;
            DY = FunctionValue(GB,U,V,1)-FY;
            DZ = 0.0;
 
-           if ( RayHitGeometry( FX,FY,FZ,DX,DY,DZ ) ) Hit-=1.0;
+           Hit -= RayHitGeometryPacket( FX,FY,FZ,DX,DY,DZ,i==Nrays-1 );
         }
 
         if ( Hit == 0 ) return;
@@ -55,7 +55,6 @@ Juha Ruokolainen/CSC - 23 Aug 1995
 #include <ViewFactors.h>
 
 static double REPS = 1.0E-4;
-#define MAX_LEVEL 16
 
 /*******************************************************************************
 
@@ -1034,302 +1033,449 @@ int RayHitRotationalQuadric1(
 
 /*******************************************************************************
 
-Solve for ray segment and hierarchy of bounding volumes of elements, return
-value is if there is hit or not.
-
-LAST Modified: 2 Sep 1997
+Bounding volume hierarchy of the ray tracing elements. The hierarchy is built
+top down by binning the element centroids and choosing the split of least
+surface area heuristic (SAH) cost. The nodes are stored in a flat array in
+depth first order: the left child of a node follows the node and the right
+child is given by index. The elements of a leaf are stored consecutively
+in BVHElements.
 
 *******************************************************************************/
 
-int RayHitVolumeBounds( VolumeBounds_t *Volume,double FX,double FY,double FZ,
-           double DX,double DY,double DZ,double L)
+#define BVH_BINS       16
+#define BVH_MAX_LEAF    8
+#define BVH_MAX_DEPTH  60
+
+typedef struct
 {
-  int i,j,n;
+    BBox_t BBox;
+    int Right;
+    int First,n;
+} BVHNode_t;
 
-  if ( !RayHitBBox( &Volume->BBox,FX,FY,FZ,DX,DY,DZ ) ) return FALSE;
+static BVHNode_t *BVHNodes = NULL;
+static int NBVHNodes = 0, *BVHElements = NULL;
 
-  if ( Volume->Left )
-  {
-    if ( RayHitVolumeBounds( Volume->Left,FX,FY,FZ,DX,DY,DZ,L ) ) return TRUE;
-    return RayHitVolumeBounds( Volume->Right,FX,FY,FZ,DX,DY,DZ,L );
-  }
+static BBox_t *BVHElemBox = NULL;
+static double *BVHCentroid = NULL, BVHPad = 0.0;
+static int BVHPlanar = FALSE;
 
-  for( i=0; i<Volume->n; i++ )
-  {
-     j = Volume->Elements[i];
-     n = RTElements[j].GeometryType;
-     if ( (*RayHit[n] )( &RTElements[j],FX,FY,FZ,DX,DY,DZ,L) ) return TRUE;
-  }
 
-  return FALSE;
+static void BoxEmpty( BBox_t *Box )
+{
+    Box->XMin = Box->YMin = Box->ZMin =  DBL_MAX;
+    Box->XMax = Box->YMax = Box->ZMax = -DBL_MAX;
 }
 
-/*******************************************************************************
-
-Solve for ray segment and geometry model intersection, return value is if
-there is hit or not.
-
-LAST Modified: 2 Sep 1997
-
-*******************************************************************************/
-int RayHitGeometry( double FX,double FY,double FZ, double DX,double DY,double DZ )
+static void BoxUnion( BBox_t *Box, BBox_t *Add )
 {
-    double L;
-    L = sqrt(DX*DX + DY*DY + DZ*DZ);
-    return  RayHitVolumeBounds( VolumeBounds,FX,FY,FZ,DX,DY,DZ,L );
+    Box->XMin = MIN( Box->XMin,Add->XMin );
+    Box->YMin = MIN( Box->YMin,Add->YMin );
+    Box->ZMin = MIN( Box->ZMin,Add->ZMin );
 
+    Box->XMax = MAX( Box->XMax,Add->XMax );
+    Box->YMax = MAX( Box->YMax,Add->YMax );
+    Box->ZMax = MAX( Box->ZMax,Add->ZMax );
 }
 
-void VolumeBBox( VolumeBounds_t *Volume,Geometry_t *RTElements )
+/*
+ * Half of the surface area of a box, or half of the perimeter for planar
+ * (2D) geometries, where all the boxes are flat.
+ */
+static double BoxMeasure( BBox_t *Box )
 {
-    double xMin,yMin,zMin,xMax,yMax,zMax,x,y,z;
-    int i,j,k,N, NC;
+    double dx,dy,dz;
 
-    double U[] = {0.0,1.0,0.0,1.0}, V[] = {0.0,0.0,1.0,1.0};
- 
-    xMin = yMin = zMin =  1.0e20;
-    xMax = yMax = zMax = -1.0e20;
+    if ( Box->XMax < Box->XMin ) return 0.0;
 
-    N = Volume->n;
-    for( i=0; i<N; i++ )
-    {
-         k = Volume->Elements[i];
-         switch(RTElements[k].GeometryType)
-         {
-            case GEOMETRY_LINE:
-              NC = 2; break;
-            case GEOMETRY_TRIANGLE:
-              NC = 3; break;
-            default:
-              NC = 4; break;
-        }
-        for( j=0; j<NC; j++ )
-          {
-            x = FunctionValue( &RTElements[k], U[j],V[j], 0);
-            y = FunctionValue( &RTElements[k], U[j],V[j], 1);
-            z = FunctionValue( &RTElements[k], U[j],V[j], 2);
+    dx = Box->XMax - Box->XMin;
+    dy = Box->YMax - Box->YMin;
+    dz = Box->ZMax - Box->ZMin;
+
+    if ( BVHPlanar ) return dx + dy + dz;
+    return dx*dy + dy*dz + dz*dx;
+}
 
-            xMin = MIN( x,xMin );
-            yMin = MIN( y,yMin );
-            zMin = MIN( z,zMin );
+/*
+ * Bounding box of an element given by the corner points, as in the
+ * earlier volume bounds.
+ */
+static void ElementBBox( Geometry_t *Elem, BBox_t *Box )
+{
+    double U[] = { 0.0,1.0,0.0,1.0 }, V[] = { 0.0,0.0,1.0,1.0 }, x,y,z;
+    int j,NC;
 
-            xMax = MAX( x,xMax );
-            yMax = MAX( y,yMax );
-            zMax = MAX( z,zMax );
-          }
+    switch( Elem->GeometryType )
+    {
+       case GEOMETRY_LINE:
+          NC = 2; break;
+       case GEOMETRY_TRIANGLE:
+          NC = 3; break;
+       default:
+          NC = 4; break;
     }
 
-    Volume->BBox.XMin = xMin;
-    Volume->BBox.XMax = xMax;
+    BoxEmpty( Box );
+    for( j=0; j<NC; j++ )
+    {
+        x = FunctionValue( Elem, U[j],V[j], 0 );
+        y = FunctionValue( Elem, U[j],V[j], 1 );
+        z = FunctionValue( Elem, U[j],V[j], 2 );
 
-    Volume->BBox.YMin = yMin;
-    Volume->BBox.YMax = yMax;
+        Box->XMin = MIN( x,Box->XMin );
+        Box->YMin = MIN( y,Box->YMin );
+        Box->ZMin = MIN( z,Box->ZMin );
 
-    Volume->BBox.ZMin = zMin;
-    Volume->BBox.ZMax = zMax;
+        Box->XMax = MAX( x,Box->XMax );
+        Box->YMax = MAX( y,Box->YMax );
+        Box->ZMax = MAX( z,Box->ZMax );
+    }
 }
 
+/*
+ * Build the subtree of elements BVHElements[First...First+n-1], return the
+ * index of the node.
+ */
+static int BVHBuild( int First, int n, int NBounds, int Depth )
+{
+    BBox_t BinBox[BVH_BINS], Box, CBox, LeftBox;
+    double Cost, BestCost, CMin, Scale, Area, LeftArea[BVH_BINS], c;
+    int BinCount[BVH_BINS], LeftCount[BVH_BINS];
+    int i,j,k,l,Axis,BestAxis,BestBin,Node,Count;
 
+    Node = NBVHNodes++;
 
-void VolumeDivide( VolumeBounds_t *Volume,int NBounds,Geometry_t *RT_Elements,int Level )
-{
-    double L1 = Volume->BBox.XMax - Volume->BBox.XMin;
-    double L2 = Volume->BBox.YMax - Volume->BBox.YMin;
-    double L3 = Volume->BBox.ZMax - Volume->BBox.ZMin;
+    BoxEmpty( &Box );
+    BoxEmpty( &CBox );
+    for( i=First; i<First+n; i++ )
+    {
+        k = BVHElements[i];
+        BoxUnion( &Box, &BVHElemBox[k] );
 
-    int NC;
-    Geometry_t *Geom;
+        CBox.XMin = MIN( CBox.XMin, BVHCentroid[3*k+0] );
+        CBox.YMin = MIN( CBox.YMin, BVHCentroid[3*k+1] );
+        CBox.ZMin = MIN( CBox.ZMin, BVHCentroid[3*k+2] );
 
-    double U[] = { 0.0,1.0,0.0,1.0 }, V[] = { 0.0,0.0,1.0,1.0 }, x,y,z;
+        CBox.XMax = MAX( CBox.XMax, BVHCentroid[3*k+0] );
+        CBox.YMax = MAX( CBox.YMax, BVHCentroid[3*k+1] );
+        CBox.ZMax = MAX( CBox.ZMax, BVHCentroid[3*k+2] );
+    }
 
-    VolumeBounds_t *LeftVolume,*RightVolume;
+    /* Enlarge the box a little, as the earlier volume bounds */
+    c = 0.001*(Box.XMax-Box.XMin) + BVHPad;
+    Box.XMin -= c; Box.XMax += c;
+    c = 0.001*(Box.YMax-Box.YMin) + BVHPad;
+    Box.YMin -= c; Box.YMax += c;
+    c = 0.001*(Box.ZMax-Box.ZMin) + BVHPad;
+    Box.ZMin -= c; Box.ZMax += c;
+
+    BVHNodes[Node].BBox  = Box;
+    BVHNodes[Node].Right = 0;
+    BVHNodes[Node].First = First;
+    BVHNodes[Node].n     = n;
+
+    if ( n <= NBounds || Depth >= BVH_MAX_DEPTH ) return Node;
+
+    /*
+     * Find the split of least SAH cost (traversal and intersection costs
+     * taken equal) among the bin boundaries in all the directions.
+     */
+    Area = BoxMeasure( &Box );
+    BestCost = DBL_MAX;
+    BestAxis = -1;
+    BestBin  = 0;
+
+    for( Axis=0; Axis<3; Axis++ )
+    {
+        if ( Axis == 0 ) { CMin = CBox.XMin; Scale = CBox.XMax - CBox.XMin; }
+        if ( Axis == 1 ) { CMin = CBox.YMin; Scale = CBox.YMax - CBox.YMin; }
+        if ( Axis == 2 ) { CMin = CBox.ZMin; Scale = CBox.ZMax - CBox.ZMin; }
+        if ( Scale <= 0.0 ) continue;
+        Scale = BVH_BINS / Scale;
 
-    int i,j,k,n,N,left,right;
+        for( j=0; j<BVH_BINS; j++ )
+        {
+            BinCount[j] = 0;
+            BoxEmpty( &BinBox[j] );
+        }
 
-    static int count;
-    double VolV,VolL,VolR;
+        for( i=First; i<First+n; i++ )
+        {
+            k = BVHElements[i];
+            j = (BVHCentroid[3*k+Axis] - CMin) * Scale;
+            j = MIN( MAX(j,0),BVH_BINS-1 );
+            BinCount[j]++;
+            BoxUnion( &BinBox[j], &BVHElemBox[k] );
+        }
 
-    LeftVolume  = Volume->Left  = (VolumeBounds_t *)calloc(1,sizeof(VolumeBounds_t));
-    RightVolume = Volume->Right = (VolumeBounds_t *)calloc(1,sizeof(VolumeBounds_t));
+        BoxEmpty( &LeftBox );
+        Count = 0;
+        for( j=0; j<BVH_BINS-1; j++ )
+        {
+            BoxUnion( &LeftBox, &BinBox[j] );
+            Count += BinCount[j];
+            LeftCount[j] = Count;
+            LeftArea[j]  = BoxMeasure( &LeftBox );
+        }
 
-    LeftVolume->BBox  = Volume->BBox;
-    RightVolume->BBox = Volume->BBox;
+        BoxEmpty( &LeftBox );
+        Count = 0;
+        for( j=BVH_BINS-1; j>0; j-- )
+        {
+            BoxUnion( &LeftBox, &BinBox[j] );
+            Count += BinCount[j];
+            if ( LeftCount[j-1] == 0 || Count == 0 ) continue;
 
-    if ( L1 > L2 &&  L1 > L3 )
-    {
-       LeftVolume->BBox.XMax = RightVolume->BBox.XMin = 
-           (Volume->BBox.XMax - Volume->BBox.XMin)/2 + Volume->BBox.XMin;
-    } else if ( L2 > L3 )
-    {
-       LeftVolume->BBox.YMax = RightVolume->BBox.YMin = 
-           (Volume->BBox.YMax - Volume->BBox.YMin)/2 + Volume->BBox.YMin;
-    } else 
-    {
-       LeftVolume->BBox.ZMax = RightVolume->BBox.ZMin = 
-           (Volume->BBox.ZMax - Volume->BBox.ZMin)/2 + Volume->BBox.ZMin;
+            Cost = LeftCount[j-1]*LeftArea[j-1] + Count*BoxMeasure( &LeftBox );
+            if ( Cost < BestCost )
+            {
+                BestCost = Cost;
+                BestAxis = Axis;
+                BestBin  = j;
+            }
+        }
     }
 
-    N = Volume->n;
-    for( i=0; i<N; i++ )
+    if ( BestAxis < 0 ) 
     {
-        k = Volume->Elements[i];
-        left = right = FALSE;
+        /* All the centroids coincide: split in the middle, if needed at all */
+        if ( n <= BVH_MAX_LEAF ) return Node;
+        l = First + n/2;
+    } else {
+        if ( Area > 0 && 1.0 + BestCost/Area >= n && n <= BVH_MAX_LEAF ) return Node;
 
-        switch(RTElements[k].GeometryType)
+        if ( BestAxis == 0 ) { CMin = CBox.XMin; Scale = CBox.XMax - CBox.XMin; }
+        if ( BestAxis == 1 ) { CMin = CBox.YMin; Scale = CBox.YMax - CBox.YMin; }
+        if ( BestAxis == 2 ) { CMin = CBox.ZMin; Scale = CBox.ZMax - CBox.ZMin; }
+        Scale = BVH_BINS / Scale;
+
+        l = First;
+        for( i=First; i<First+n; i++ )
         {
-          case GEOMETRY_LINE:
-              NC = 2; break;
-          case GEOMETRY_TRIANGLE:
-              NC = 3; break;
-          default:
-              NC = 4; break;
+            k = BVHElements[i];
+            j = (BVHCentroid[3*k+BestAxis] - CMin) * Scale;
+            j = MIN( MAX(j,0),BVH_BINS-1 );
+            if ( j < BestBin )
+            {
+                BVHElements[i] = BVHElements[l];
+                BVHElements[l++] = k;
+            }
         }
+    }
 
-        for( j=0; j<NC; j++ )
-        {
-           x = FunctionValue( &RTElements[k], U[j],V[j], 0);
-           y = FunctionValue( &RTElements[k], U[j],V[j], 1);
-           z = FunctionValue( &RTElements[k], U[j],V[j], 2);
+    BVHBuild( First, l-First, NBounds, Depth+1 );
+    BVHNodes[Node].Right = BVHBuild( l, First+n-l, NBounds, Depth+1 );
+    BVHNodes[Node].n = 0;
 
-           if ( (x >= LeftVolume->BBox.XMin) && (x <= LeftVolume->BBox.XMax) )
-           if ( (y >= LeftVolume->BBox.YMin) && (y <= LeftVolume->BBox.YMax) )
-           if ( (z >= LeftVolume->BBox.ZMin) && (z <= LeftVolume->BBox.ZMax) )  left = TRUE;
+    return Node;
+}
 
-           if ( (x >= RightVolume->BBox.XMin) && (x <= RightVolume->BBox.XMax) )
-           if ( (y >= RightVolume->BBox.YMin) && (y <= RightVolume->BBox.YMax) )
-           if ( (z >= RightVolume->BBox.ZMin) && (z <= RightVolume->BBox.ZMax) ) right = TRUE;
-        }
-        if ( left )  LeftVolume->n++; else if ( right ) RightVolume->n++;
-    }
 
-    LeftVolume->Elements  = (int *)calloc( LeftVolume->n,sizeof(int) );
-    LeftVolume->n = 0;
+/*******************************************************************************
 
-    RightVolume->Elements = (int *)calloc( RightVolume->n,sizeof(int) );
-    RightVolume->n = 0;
+Solve for ray segment and geometry model intersection, return value is if
+there is hit or not.
 
-    for( i=0; i<N; i++ )
+*******************************************************************************/
+int RayHitGeometry( double FX,double FY,double FZ, double DX,double DY,double DZ )
+{
+    int i,j,Node,Stack[BVH_MAX_DEPTH+2],sp;
+    double L;
+
+    L = sqrt(DX*DX + DY*DY + DZ*DZ);
+
+    sp = 0;
+    Stack[sp++] = 0;
+    while( sp > 0 )
     {
-        k = Volume->Elements[i];
-        left = right = FALSE;
+        BVHNode_t *BVH = &BVHNodes[Stack[--sp]];
+
+        if ( !RayHitBBox( &BVH->BBox,FX,FY,FZ,DX,DY,DZ ) ) continue;
 
-        switch(RTElements[k].GeometryType)
+        if ( BVH->Right )
         {
-          case GEOMETRY_LINE:
-            NC = 2; break;
-          case GEOMETRY_TRIANGLE:
-            NC = 3; break;
-          default:
-            NC = 4; break;
+            Stack[sp++] = BVH->Right;
+            Stack[sp++] = BVH - BVHNodes + 1;
+            continue;
         }
-        for( j=0; j<NC; j++ )
-        {
-           x = FunctionValue( &RTElements[k], U[j],V[j], 0);
-           y = FunctionValue( &RTElements[k], U[j],V[j], 1);
-           z = FunctionValue( &RTElements[k], U[j],V[j], 2);
-
-           if ( (x >= LeftVolume->BBox.XMin) && (x <= LeftVolume->BBox.XMax) )
-           if ( (y >= LeftVolume->BBox.YMin) && (y <= LeftVolume->BBox.YMax) )
-           if ( (z >= LeftVolume->BBox.ZMin) && (z <= LeftVolume->BBox.ZMax) )  left = TRUE;
 
-           if ( (x >= RightVolume->BBox.XMin) && (x <= RightVolume->BBox.XMax) )
-           if ( (y >= RightVolume->BBox.YMin) && (y <= RightVolume->BBox.YMax) )
-           if ( (z >= RightVolume->BBox.ZMin) && (z <= RightVolume->BBox.ZMax) ) right = TRUE;
+        for( i=BVH->First; i<BVH->First+BVH->n; i++ )
+        {
+            j = BVHElements[i];
+            if ( (*RayHit[RTElements[j].GeometryType])( &RTElements[j],FX,FY,FZ,DX,DY,DZ,L ) ) 
+              return TRUE;
         }
-        if ( left )  LeftVolume->Elements[LeftVolume->n++] = k;
-        else if ( right ) RightVolume->Elements[RightVolume->n++] = k;
     }
 
-    VolumeBBox( LeftVolume,  RTElements );
-    VolumeBBox( RightVolume, RTElements );
+    return FALSE;
+}
 
-    if ( L1 > L2 && L1 > L3 )
-    {
-        VolV = L1;
-        VolL = LeftVolume->BBox.XMax  - LeftVolume->BBox.XMin;
-        VolR = RightVolume->BBox.XMax - RightVolume->BBox.XMin;
-    } else if ( L2 > L3 ) {
-        VolV = L2;
-        VolL = LeftVolume->BBox.YMax  - LeftVolume->BBox.YMin;
-        VolR = RightVolume->BBox.YMax - RightVolume->BBox.YMin;
-    } else {
-        VolV = L3;
-        VolL = LeftVolume->BBox.ZMax  - LeftVolume->BBox.ZMin;
-        VolR = RightVolume->BBox.ZMax - RightVolume->BBox.ZMin;
-    }
 
-    count += 2;
-    if ( VolL-VolV > -1.0e-12 || VolR-VolV > -1.0e-12 )
-    {
-        free( LeftVolume->Elements );
-        free( LeftVolume );
+/*******************************************************************************
 
-        free( RightVolume->Elements );
-        free( RightVolume);
+Trace a packet of ray segments through the hierarchy together. Each node is
+visited once for the whole packet, and the box tests of the packet are done
+in a loop over the rays that vectorizes. Return value is the number of rays
+that hit the geometry.
 
-        Volume->Left = Volume->Right = NULL;
-        count -= 2;
+*******************************************************************************/
+typedef struct
+{
+    int n;
+    double FX[RAY_PACKET],FY[RAY_PACKET],FZ[RAY_PACKET];
+    double DX[RAY_PACKET],DY[RAY_PACKET],DZ[RAY_PACKET];
+} RayPacket_t;
 
-        return;
-    }
+static RayPacket_t Packet;
+#pragma omp threadprivate(Packet)
 
-    if ( LeftVolume->n >NBounds && Level<MAX_LEVEL )
-      VolumeDivide( LeftVolume,NBounds,RTElements, Level+1 );
+static int RayPacketTrace( RayPacket_t *P )
+{
+    double IX[RAY_PACKET],IY[RAY_PACKET],IZ[RAY_PACKET],L,
+        T0,T1,TMin,TMax,XMin,XMax,YMin,YMax,ZMin,ZMax;
+    int Alive[RAY_PACKET],Mask[RAY_PACKET],Stack[BVH_MAX_DEPTH+2];
+    int i,j,r,n=P->n,sp,Any,Hits=0;
 
-    if ( RightVolume->n>NBounds && Level<MAX_LEVEL )
-      VolumeDivide( RightVolume,NBounds,RTElements,Level+1 );
+    /* Inverse directions, zero components replaced by tiny ones of the same sign */
+    for( r=0; r<n; r++ )
+    {
+        IX[r] = 1.0 / (ABS(P->DX[r])<1.0e-12 ? (P->DX[r]<0 ? -1.0e-12 : 1.0e-12) : P->DX[r]);
+        IY[r] = 1.0 / (ABS(P->DY[r])<1.0e-12 ? (P->DY[r]<0 ? -1.0e-12 : 1.0e-12) : P->DY[r]);
+        IZ[r] = 1.0 / (ABS(P->DZ[r])<1.0e-12 ? (P->DZ[r]<0 ? -1.0e-12 : 1.0e-12) : P->DZ[r]);
+        Alive[r] = 1;
+    }
 
-    LeftVolume->BBox.XMin = LeftVolume->BBox.XMin - 
-        0.001*(LeftVolume->BBox.XMax-LeftVolume->BBox.XMin);
+    sp = 0;
+    Stack[sp++] = 0;
+    while( sp > 0 && Hits < n )
+    {
+        BVHNode_t *BVH = &BVHNodes[Stack[--sp]];
+
+        XMin = BVH->BBox.XMin; XMax = BVH->BBox.XMax;
+        YMin = BVH->BBox.YMin; YMax = BVH->BBox.YMax;
+        ZMin = BVH->BBox.ZMin; ZMax = BVH->BBox.ZMax;
 
-    LeftVolume->BBox.XMax = LeftVolume->BBox.XMax +
-        0.001*(LeftVolume->BBox.XMax-LeftVolume->BBox.XMin);
+        /* Slab test of the segments 0<=t<=1 that are not yet blocked */
+        Any = 0;
+#pragma omp simd private(T0,T1,TMin,TMax) reduction(|:Any)
+        for( r=0; r<n; r++ )
+        {
+            T0 = (XMin - P->FX[r])*IX[r];
+            T1 = (XMax - P->FX[r])*IX[r];
+            TMin = MIN(T0,T1);
+            TMax = MAX(T0,T1);
+
+            T0 = (YMin - P->FY[r])*IY[r];
+            T1 = (YMax - P->FY[r])*IY[r];
+            TMin = MAX(TMin,MIN(T0,T1));
+            TMax = MIN(TMax,MAX(T0,T1));
+
+            T0 = (ZMin - P->FZ[r])*IZ[r];
+            T1 = (ZMax - P->FZ[r])*IZ[r];
+            TMin = MAX(TMin,MIN(T0,T1));
+            TMax = MIN(TMax,MAX(T0,T1));
+
+            TMin = MAX(TMin,0.0);
+            TMax = MIN(TMax,1.0);
+
+            Mask[r] = Alive[r] & (TMin <= TMax);
+            Any |= Mask[r];
+        }
+        if ( !Any ) continue;
 
-    LeftVolume->BBox.YMin = LeftVolume->BBox.YMin - 
-        0.001*(LeftVolume->BBox.YMax-LeftVolume->BBox.YMin);
+        if ( BVH->Right )
+        {
+            Stack[sp++] = BVH->Right;
+            Stack[sp++] = BVH - BVHNodes + 1;
+            continue;
+        }
 
-    LeftVolume->BBox.YMax = LeftVolume->BBox.YMax +
-        0.001*(LeftVolume->BBox.YMax-LeftVolume->BBox.YMin);
+        for( r=0; r<n; r++ )
+        {
+            if ( !Mask[r] ) continue;
 
-    LeftVolume->BBox.ZMin = LeftVolume->BBox.ZMin - 
-        0.001*(LeftVolume->BBox.ZMax-LeftVolume->BBox.ZMin);
+            L = sqrt( P->DX[r]*P->DX[r] + P->DY[r]*P->DY[r] + P->DZ[r]*P->DZ[r] );
+            for( i=BVH->First; i<BVH->First+BVH->n; i++ )
+            {
+                j = BVHElements[i];
+                if ( (*RayHit[RTElements[j].GeometryType])( &RTElements[j],
+                        P->FX[r],P->FY[r],P->FZ[r],P->DX[r],P->DY[r],P->DZ[r],L ) )
+                {
+                    Alive[r] = 0;
+                    Hits++;
+                    break;
+                }
+            }
+        }
+    }
 
-    LeftVolume->BBox.ZMax = LeftVolume->BBox.ZMax + 
-        0.001*(LeftVolume->BBox.ZMax-LeftVolume->BBox.ZMin);
+    return Hits;
+}
 
+/*******************************************************************************
 
-    RightVolume->BBox.XMin = RightVolume->BBox.XMin - 
-        0.001*(RightVolume->BBox.XMax-RightVolume->BBox.XMin);
+Add a ray segment to the packet of the calling thread. The packet is traced
+when it is full or when 'Flush' is set, and the number of the traced rays that
+hit the geometry is returned. Otherwise the return value is zero.
 
-    RightVolume->BBox.XMax = RightVolume->BBox.XMax + 
-        0.001*(RightVolume->BBox.XMax-RightVolume->BBox.XMin);
+*******************************************************************************/
+int RayHitGeometryPacket( double FX,double FY,double FZ,
+          double DX,double DY,double DZ,int Flush )
+{
+    int n = Packet.n++;
 
-    RightVolume->BBox.YMin = RightVolume->BBox.YMin -
-        0.001*(RightVolume->BBox.YMax-RightVolume->BBox.YMin);
+    Packet.FX[n] = FX; Packet.FY[n] = FY; Packet.FZ[n] = FZ;
+    Packet.DX[n] = DX; Packet.DY[n] = DY; Packet.DZ[n] = DZ;
 
-    RightVolume->BBox.YMax = RightVolume->BBox.YMax +
-        0.001*(RightVolume->BBox.YMax-RightVolume->BBox.YMin);
+    if ( Packet.n < RAY_PACKET && !Flush ) return 0;
 
-    RightVolume->BBox.ZMin = RightVolume->BBox.ZMin -
-        0.001*(RightVolume->BBox.ZMax-RightVolume->BBox.ZMin);
+    n = RayPacketTrace( &Packet );
+    Packet.n = 0;
 
-    RightVolume->BBox.ZMax = RightVolume->BBox.ZMax + 
-        0.001*(RightVolume->BBox.ZMax-RightVolume->BBox.ZMin);
+    return n;
 }
 
 
 void InitVolumeBounds( int NBounds,int N,Geometry_t *RTElements )
 {
+    BBox_t Box;
+    double d;
     int i;
 
-    VolumeBounds = (VolumeBounds_t *)calloc( 1,sizeof(VolumeBounds_t) );
-    VolumeBounds->n = N;
+    BVHElemBox  = (BBox_t *)malloc( N*sizeof(BBox_t) );
+    BVHCentroid = (double *)malloc( 3*N*sizeof(double) );
+    BVHElements = (int *)malloc( N*sizeof(int) );
+    BVHNodes    = (BVHNode_t *)malloc( MAX(2*N-1,1)*sizeof(BVHNode_t) );
+
+    BoxEmpty( &Box );
+    for( i=0; i<N; i++ )
+    {
+        ElementBBox( &RTElements[i],&BVHElemBox[i] );
+        BoxUnion( &Box,&BVHElemBox[i] );
+
+        BVHCentroid[3*i+0] = 0.5*(BVHElemBox[i].XMin + BVHElemBox[i].XMax);
+        BVHCentroid[3*i+1] = 0.5*(BVHElemBox[i].YMin + BVHElemBox[i].YMax);
+        BVHCentroid[3*i+2] = 0.5*(BVHElemBox[i].ZMin + BVHElemBox[i].ZMax);
+
+        BVHElements[i] = i;
+    }
 
-    VolumeBounds->Elements = (int *)malloc( N*sizeof(int) );
-    for( i=0;i<N; i++ ) VolumeBounds->Elements[i] = i;
+    d = (Box.XMax-Box.XMin) + (Box.YMax-Box.YMin) + (Box.ZMax-Box.ZMin);
+    BVHPad = 1.0e-10 * d;
+    BVHPlanar = N > 0 && Box.ZMax - Box.ZMin <= 1.0e-12 * d;
+
+    NBVHNodes = 0;
+    if ( N > 0 ) 
+      BVHBuild( 0,N,MAX(NBounds,1),0 );
+    else
+    {
+      BoxEmpty( &BVHNodes[0].BBox );
+      BVHNodes[0].Right = BVHNodes[0].First = BVHNodes[0].n = 0;
+      NBVHNodes = 1;
+    }
 
-    VolumeBBox( VolumeBounds,RTElements );
-    VolumeDivide( VolumeBounds,NBounds,RTElements,0 );
+    free( BVHElemBox );  BVHElemBox  = NULL;
+    free( BVHCentroid ); BVHCentroid = NULL;
 }
 
 void InitRayTracer(double eps)
@@ -461,22 +461,22 @@ void TriangleComputeViewFactors(Geometry_t *GA,Geometry_t *GB,
         Hit = Nrays;
         for( i=0; i<Nrays; i++ )
         {
-            U = drand48(); V=drand48();
-            while( U+V>1.0 ) { U = drand48(); V = drand48(); }
+            U = ViewFactorRandom(); V=ViewFactorRandom();
+            while( U+V>1.0 ) { U = ViewFactorRandom(); V = ViewFactorRandom(); }
 
             FX = TriangleValue(U,V,AX);
             FY = TriangleValue(U,V,AY);
             FZ = TriangleValue(U,V,AZ);
 
-            U = drand48(); V=drand48();
+            U = ViewFactorRandom(); V=ViewFactorRandom();
             if ( GB->GeometryType == GEOMETRY_TRIANGLE )
-              while( U+V>1.0 ) { U = drand48(); V = drand48(); }
+              while( U+V>1.0 ) { U = ViewFactorRandom(); V = ViewFactorRandom(); }
 
             DX = FunctionValue(GB,U,V,0) - FX;
             DY = FunctionValue(GB,U,V,1) - FY;
             DZ = FunctionValue(GB,U,V,2) - FZ;
 
-            Hit -= RayHitGeometry( FX,FY,FZ,DX,DY,DZ );
+            Hit -= RayHitGeometryPacket( FX,FY,FZ,DX,DY,DZ,i==Nrays-1 );
         }
 
         if ( Hit == 0 ) return;
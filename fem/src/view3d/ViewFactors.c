@@ -67,8 +67,31 @@ double drand48()
 
 extern double ShapeFunctionMatrix3[3][3],ShapeFunctionMatrix4[4][4];
 
+/*******************************************************************************
+
+Random numbers for the ray tracing. Each thread has a generator of its own
+(the drand48 congruential sequence) that is reseeded for each element pair,
+so that the view factors do not depend on the number of threads.
+
+*******************************************************************************/
+static unsigned long long RandomState;
+#pragma omp threadprivate(RandomState)
+
+void ViewFactorSeed( int i,int j )
+{
+     unsigned long long z = ((unsigned long long)i << 32) + j + 0x9E3779B97F4A7C15ULL;
+
+     z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+     z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+     RandomState = (z ^ (z >> 31)) & 0xFFFFFFFFFFFFULL;
+}
+
+double ViewFactorRandom()
+{
+     RandomState = (0x5DEECE66DULL*RandomState + 0xB) & 0xFFFFFFFFFFFFULL;
+     return RandomState / 281474976710656.0;
+}
 
-static int MaxLev;
 /*******************************************************************************
 
 Compute viewfactor from hierarchy
@@ -93,8 +116,7 @@ static double ComputeViewFactorValue( Geometry_t *Geom,int Level )
      {
         S += ComputeViewFactorValue( Geom->Left,Level+1 );
         S += ComputeViewFactorValue( Geom->Right,Level+1 );
-     } else
-       MaxLev = MAX(MaxLev,Level);
+     }
 
      return S;
 }
@@ -210,10 +232,10 @@ or radiosity, if requested.
 *******************************************************************************/
 static void IntegrateFromGeometry(int N,double *Factors)
 {
-    double T,s,F,Fmin=DBL_MAX,Fmax=-DBL_MAX,Favg=0.0,*RowSums,Fact;
+    double s,Fact,Fmin=DBL_MAX,Fmax=-DBL_MAX,Favg=0.0;
     int i,j,k,Imin,Imax;
 
-    GeometryList_t *Link;
+    Geometry_t GA,GB;
 
     for( i=0; i<N; i++ )
     {
@@ -221,48 +243,63 @@ static void IntegrateFromGeometry(int N,double *Factors)
         Elements[i].Flags |= GEOMETRY_FLAG_LEAF;
     }
 
-    RowSums = (double *)calloc( N,sizeof(double) );
-
-    MaxLev = 0;
-    k = 0;
+    /*
+     * The rows are computed concurrently. The subdivision hierarchies and
+     * the links are built for private copies of the elements, so that the
+     * shared elements and ray tracing structures are only read. Row i sets
+     * entries (i,j) and (j,i), j>i, so the rows never write the same entry.
+     */
+#pragma omp parallel for private(j,Fact,GA,GB) schedule(dynamic,1)
     for( i=0; i<N; i++ )
     {
          for( j=i; j<N; j++ ) Factors[i*N+j] = 0.0;
          if ( Elements[i].Area<1.0e-10 ) continue;
 
-         fprintf( stdout, "row = % 4d of %d: ",i+1,N );
+         GA = Elements[i];
+         GA.Link = NULL;
+         GA.Left = GA.Right = NULL;
+
          for( j=i+1; j<N; j++ )
          { 
             if ( Elements[j].Area<1.0e-10 ) continue;
 
-            FreeLinks( &Elements[i] );
-            FreeLinks( &Elements[j] );
+            GB = Elements[j];
+            GB.Link = NULL;
+            GB.Left = GB.Right = NULL;
 
-            Elements[i].Flags |= GEOMETRY_FLAG_LEAF;
-            Elements[j].Flags |= GEOMETRY_FLAG_LEAF;
+            FreeLinks( &GA );
 
-            (*ViewFactorCompute[Elements[i].GeometryType])( &Elements[i],&Elements[j],0,0 );
+            GA.Flags |= GEOMETRY_FLAG_LEAF;
+            GB.Flags |= GEOMETRY_FLAG_LEAF;
+
+            ViewFactorSeed( i,j );
+            (*ViewFactorCompute[GA.GeometryType])( &GA,&GB,0,0 );
   
-            Fact = ComputeViewFactorValue( &Elements[i],0 );
-            Factors[i*N+j] = Fact / Elements[i].Area;
-            Factors[j*N+i] = Fact / Elements[j].Area;
-         }
+            Fact = ComputeViewFactorValue( &GA,0 );
+            Factors[i*N+j] = Fact / GA.Area;
+            Factors[j*N+i] = Fact / GB.Area;
 
-         fflush( stdout );
+            FreeLinks( &GB );
+            FreeChilds( GB.Left );
+            FreeChilds( GB.Right );
+         }
 
-         FreeChilds( Elements[i].Left );
-         Elements[i].Left = NULL;
+         FreeLinks( &GA );
+         FreeChilds( GA.Left );
+         FreeChilds( GA.Right );
+    }
 
-         FreeChilds( Elements[i].Right );
-         Elements[i].Right = NULL;
+    k = 0;
+    for( i=0; i<N; i++ )
+    {
+         if ( Elements[i].Area<1.0e-10 ) continue;
 
-         RowSums[i] = 0.0;
+         s = 0.0;
          for( j=0; j<N; j++ )
          {
            if ( Elements[j].Area < 1.0e-10 ) continue;
-           RowSums[i] += Factors[i*N+j];
+           s += Factors[i*N+j];
          }
-         s = RowSums[i];
          if ( s < Fmin )
          {
             Fmin = s;
@@ -276,11 +313,10 @@ static void IntegrateFromGeometry(int N,double *Factors)
          Favg += s;
          k++;
 
-         fprintf( stdout, "sum=%-4.2f, (min(%d)=%-4.2f, max(%d)=%-4.2f, avg=%-4.2f)\n", 
-                        s,Imin,Fmin,Imax,Fmax,Favg/k );
+         fprintf( stdout, "row = % 4d of %d: sum=%-4.2f, (min(%d)=%-4.2f, max(%d)=%-4.2f, avg=%-4.2f)\n", 
+                        i+1,N,s,Imin,Fmin,Imax,Fmax,Favg/k );
     }
-
-    free( RowSums );
+    fflush( stdout );
 }
 
 void MakeViewFactorMatrix(int N,double *Factors,int NInteg,int NInteg3)
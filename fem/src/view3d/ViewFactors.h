@@ -260,22 +260,13 @@ typedef struct Geometry
 #define Cylinder    GeometryEntry.Cylinder
 #define RotQuadric  GeometryEntry.RotQuadric
 
-typedef struct VolumeBounds
-{
-   struct VolumeBounds *Left,*Right;
-
-   BBox_t BBox;
-   int n;
-   int *Elements;
-} VolumeBounds_t;
-
-EXT VolumeBounds_t *VolumeBounds;
-EXT int NVolumeBounds,*VolumeTested;
+#define RAY_PACKET 32
 
 EXT int NGeomElem,NElements;
 
 EXT int (*RayHit[MAX_GEOMETRY_TYPES])(Geometry_t *,double,double,double,double,double,double,double);
-EXT int RayHitGeometry(double,double,double,double,double,double );
+int RayHitGeometry(double,double,double,double,double,double );
+int RayHitGeometryPacket(double,double,double,double,double,double,int);
 void InitRayTracer(double);
 void InitVolumeBounds( int,int,Geometry_t * );
 
@@ -384,6 +375,9 @@ EXT void (*ViewFactorCompute[MAX_GEOMETRY_TYPES])(Geometry_t *,Geometry_t *,int,
 EXT void (*Subdivide[MAX_GEOMETRY_TYPES])(Geometry_t *,int,int);
 EXT double (*IntegrateDiffToArea[MAX_GEOMETRY_TYPES])(Geometry_t *,double,double,double,double,double,double);
 
+void ViewFactorSeed( int,int );
+double ViewFactorRandom();
+
 void OutputGeometry( Geometry_t *,int );
 void LinearSolveGaussSeidel( Geometry_t *,int,double *);
 
@@ -0,0 +1,5 @@
+include(test_macros)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 square -binary)
+# Remove the ascii mesh to make sure that the binary one is used
+file(REMOVE square/mesh.header square/mesh.nodes square/mesh.elements square/mesh.boundary)
+RUN_ELMER_TEST()
@@ -0,0 +1,10 @@
+include(test_macros)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 square -partition ${MPIEXEC_NTASKS} 1 0 -binary)
+# Remove the ascii partitions to make sure that the binary ones are used
+file(GLOB ascii_files square/partitioning.${MPIEXEC_NTASKS}/part.*.header
+  square/partitioning.${MPIEXEC_NTASKS}/part.*.nodes
+  square/partitioning.${MPIEXEC_NTASKS}/part.*.elements
+  square/partitioning.${MPIEXEC_NTASKS}/part.*.boundary
+  square/partitioning.${MPIEXEC_NTASKS}/part.*.shared)
+file(REMOVE ${ascii_files})
+RUN_ELMER_TEST()
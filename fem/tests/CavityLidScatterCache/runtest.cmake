@@ -0,0 +1,3 @@
+include(test_macros)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 square)
+RUN_ELMER_TEST()
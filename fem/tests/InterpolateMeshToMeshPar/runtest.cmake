@@ -0,0 +1,4 @@
+include(test_macros)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 angle -partdual -metis ${MPIEXEC_NTASKS} 3 -nooverwrite)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 square -partition 1 ${MPIEXEC_NTASKS} 1 -nooverwrite)
+RUN_ELMER_TEST()
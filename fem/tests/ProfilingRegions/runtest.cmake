@@ -0,0 +1,30 @@
+include(test_macros)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 square -metis ${MPIEXEC_NTASKS} 3 -nooverwrite)
+
+# Each partition writes its own trace file when there are several of them
+IF(MPIEXEC_NTASKS GREATER 1)
+  SET(TraceFiles trace_0.json trace_1.json)
+ELSE()
+  SET(TraceFiles trace.json)
+ENDIF()
+FILE(REMOVE profiling.dat ${TraceFiles})
+
+RUN_ELMER_TEST()
+
+# The summary and the traces must have been written and list the named regions
+FOREACH(f profiling.dat ${TraceFiles})
+  IF(NOT EXISTS "${CMAKE_CURRENT_BINARY_DIR}/${f}")
+    MESSAGE(FATAL_ERROR "Profiling output ${f} was not written")
+  ENDIF()
+  FILE(READ "${CMAKE_CURRENT_BINARY_DIR}/${f}" Contents)
+  SET(Regions "heat equation" "Assembly" "DefaultSolve" "IterSolver")
+  IF(NOT f STREQUAL "profiling.dat")
+    LIST(APPEND Regions "traceEvents")
+  ENDIF()
+  FOREACH(region ${Regions})
+    STRING(FIND "${Contents}" "${region}" pos)
+    IF(pos LESS 0)
+      MESSAGE(FATAL_ERROR "Region '${region}' is missing from ${f}")
+    ENDIF()
+  ENDFOREACH()
+ENDFOREACH()
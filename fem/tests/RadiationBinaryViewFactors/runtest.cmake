@@ -0,0 +1,5 @@
+include(test_macros)
+
+# A view factors file from an earlier run could be in another format
+file(REMOVE radiation/ViewFactors.dat)
+RUN_ELMER_TEST()
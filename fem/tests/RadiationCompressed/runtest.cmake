@@ -0,0 +1,3 @@
+include(test_macros)
+
+RUN_ELMER_TEST()
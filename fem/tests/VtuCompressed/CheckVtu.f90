@@ -0,0 +1,123 @@
+!------------------------------------------------------------------------------
+!> Reads back a nodal Float64 array of a vtu file saved with zlib compressed
+!> appended data and stores it in the variable of the solver. The inflated
+!> values must be bitwise identical to the field that was saved.
+!------------------------------------------------------------------------------
+SUBROUTINE CheckVtuSolver( Model,Solver,dt,TransientSimulation )
+!------------------------------------------------------------------------------
+  USE DefUtils
+  USE ISO_C_BINDING
+
+  IMPLICIT NONE
+!------------------------------------------------------------------------------
+  TYPE(Solver_t) :: Solver
+  TYPE(Model_t) :: Model
+  REAL(KIND=dp) :: dt
+  LOGICAL :: TransientSimulation
+!------------------------------------------------------------------------------
+  INTERFACE
+    FUNCTION zlib_uncompress( dest, destlen, source, sourcelen ) &
+        RESULT( stat ) BIND(C,NAME='uncompress')
+      IMPORT :: C_CHAR, C_LONG, C_INT
+      CHARACTER(KIND=C_CHAR) :: dest(*), source(*)
+      INTEGER(KIND=C_LONG) :: destlen
+      INTEGER(KIND=C_LONG), VALUE :: sourcelen
+      INTEGER(KIND=C_INT) :: stat
+    END FUNCTION zlib_uncompress
+  END INTERFACE
+
+  TYPE(ValueList_t), POINTER :: Params
+  TYPE(Mesh_t), POINTER :: Mesh
+  TYPE(Variable_t), POINTER :: Var
+  CHARACTER(LEN=MAX_NAME_LEN) :: FileName, ArrayName
+  CHARACTER(LEN=:), ALLOCATABLE :: Buf
+  CHARACTER(KIND=C_CHAR), ALLOCATABLE :: Raw(:)
+  REAL(KIND=dp), ALLOCATABLE :: Vals(:)
+  INTEGER(KIND=C_LONG) :: RawLen
+  INTEGER(KIND=C_INT32_T) :: Head(3)
+  INTEGER, ALLOCATABLE :: CompSizes(:)
+  INTEGER :: FileSize, i, j, k, n, p, q, Offset, NoBlocks, io
+  REAL(KIND=dp) :: Diff
+  CHARACTER(*), PARAMETER :: Caller = 'CheckVtuSolver'
+!------------------------------------------------------------------------------
+  Params => GetSolverParams()
+  Mesh => GetMesh()
+  n = Mesh % NumberOfNodes
+
+  FileName = ListGetString( Params,'Vtu File',UnfoundFatal=.TRUE.)
+  ArrayName = ListGetString( Params,'Vtu Array',UnfoundFatal=.TRUE.)
+
+  OPEN( 10, FILE=TRIM(FileName), ACCESS='STREAM', FORM='UNFORMATTED', &
+      STATUS='OLD', ACTION='READ', IOSTAT=io )
+  IF( io /= 0 ) CALL Fatal(Caller,'Could not open file: '//TRIM(FileName))
+  INQUIRE( 10, SIZE=FileSize )
+  ALLOCATE( CHARACTER(LEN=FileSize) :: Buf )
+  READ( 10 ) Buf
+  CLOSE( 10 )
+
+  IF( INDEX( Buf,'compressor="vtkZLibDataCompressor"' ) == 0 ) THEN
+    CALL Fatal(Caller,'File is not compressed: '//TRIM(FileName))
+  END IF
+
+  ! Offset of the array within the appended data
+  p = INDEX( Buf,'Name="'//TRIM(ArrayName)//'"' )
+  IF( p == 0 ) CALL Fatal(Caller,'Array not found: '//TRIM(ArrayName))
+  IF( INDEX( Buf(1:p),'type="Float64"',BACK=.TRUE. ) == 0 ) THEN
+    CALL Fatal(Caller,'Array is not of type Float64: '//TRIM(ArrayName))
+  END IF
+  q = p + INDEX( Buf(p:),'offset="' ) + 7
+  READ( Buf(q:q+INDEX(Buf(q:),'"')-2), * ) Offset
+
+  ! The appended data starts after the underscore
+  p = INDEX( Buf,'<AppendedData encoding="raw">' )
+  IF( p == 0 ) CALL Fatal(Caller,'No appended data in file: '//TRIM(FileName))
+  p = p + INDEX( Buf(p:),'_' ) + Offset
+
+  ! Block header: number of blocks, block size, size of the last block
+  ! and the compressed sizes of the blocks.
+  Head = TRANSFER( Buf(p:p+11), Head )
+  NoBlocks = Head(1)
+  IF( (NoBlocks-1) * Head(2) + Head(3) /= 8*n ) THEN
+    CALL Fatal(Caller,'Size in the block header does not match the number of nodes!')
+  END IF
+  ALLOCATE( CompSizes(NoBlocks), Raw(8*n), Vals(n) )
+  CompSizes = TRANSFER( Buf(p+12:p+11+4*NoBlocks), CompSizes )
+  CALL Info(Caller,'Number of compressed blocks: '//TRIM(I2S(NoBlocks)),Level=5)
+
+  p = p + 12 + 4*NoBlocks
+  k = 1
+  DO i=1,NoBlocks
+    IF( i < NoBlocks ) THEN
+      RawLen = Head(2)
+    ELSE
+      RawLen = Head(3)
+    END IF
+    j = RawLen
+    IF( zlib_uncompress( Raw(k:), RawLen, Buf(p:p+CompSizes(i)-1), &
+        INT(CompSizes(i),C_LONG) ) /= 0 .OR. RawLen /= j ) THEN
+      CALL Fatal(Caller,'Could not inflate block: '//TRIM(I2S(i)))
+    END IF
+    p = p + CompSizes(i)
+    k = k + j
+  END DO
+  Vals = TRANSFER( Raw, Vals )
+
+  ! Compare to the field that was saved
+  Var => VariableGet( Mesh % Variables, ArrayName )
+  IF( .NOT. ASSOCIATED( Var ) ) CALL Fatal(Caller,'Variable not found: '//TRIM(ArrayName))
+  Diff = 0.0_dp
+  DO i=1,n
+    IF( Var % Perm(i) > 0 ) Diff = MAX( Diff, ABS( Vals(i) - Var % Values(Var % Perm(i)) ) )
+    IF( Solver % Variable % Perm(i) > 0 ) THEN
+      Solver % Variable % Values( Solver % Variable % Perm(i) ) = Vals(i)
+    END IF
+  END DO
+  IF( Diff > 0.0_dp ) THEN
+    WRITE( Message,'(A,ES12.3)') 'Inflated data differs from the field: ',Diff
+    CALL Fatal(Caller,Message)
+  END IF
+
+  Solver % Variable % Norm = ComputeNorm( Solver, SIZE( Solver % Variable % Values ) )
+!------------------------------------------------------------------------------
+END SUBROUTINE CheckVtuSolver
+!------------------------------------------------------------------------------
@@ -0,0 +1,4 @@
+include(test_macros)
+execute_process(COMMAND ${ELMERGRID_BIN} 1 2 winkel -nooverwrite)
+
+RUN_ELMER_TEST()
@@ -126,6 +126,7 @@
 ! Parallel environment parameters (20-29)
 #define HUTI_MYPROC ipar(20)
 #define HUTI_PROCS ipar(21)
+#define HUTI_GLOBAL_REDUCE ipar(22)
 
 ! Robust methods
 #define HUTI_ROBUST ipar(26)
@@ -7,6 +7,9 @@
 /* matc.c  */
 
 char *doread( void );
+void *mtc_compile( char * );
+void mtc_setvar( char *, double *, int );
+int mtc_evalcode( void *, double *, char ** );
 VARIABLE *com_quit( void );
 
 /*
@@ -181,6 +184,7 @@ void free_treeentry( TREEENTRY *);
 void free_tree( TREE *);
 void free_clause( CLAUSE *);
 
+CLAUSE *doparse( char *);
 VARIABLE *doit( char *);
 
 /* printclause.c */
@@ -390,6 +390,13 @@ EXT jmp_buf *jmpbuf;
 EXT int term;
 #pragma omp threadprivate(term)
 
+/*
+     see mtc_evalcode() in matc.c and put_result() in eval.c
+*/
+EXT int math_capture, math_captured;
+EXT double math_captured_value;
+#pragma omp threadprivate(math_capture, math_captured, math_captured_value)
+
 #ifdef VAX
 struct desc
 { 
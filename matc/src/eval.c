@@ -928,7 +928,22 @@ VARIABLE *put_result(ptr, resname, par, indexflag, printflag)
   }
 
   if ( res ) res->changed = 1;
-  if (printflag) var_print(res);
+  if (printflag)
+  {
+    /*
+     *  compiled code evaluation takes the first printed value as is
+     */
+    if (math_capture)
+    {
+      if (!math_captured && res && TYPE(res) == TYPE_DOUBLE && NROW(res)*NCOL(res) > 0)
+      {
+        math_captured_value = *MATR(res);
+        math_captured = TRUE;
+      }
+    }
+    else
+      var_print(res);
+  }
 
   return res;
 }
@@ -306,6 +306,136 @@ char * mtc_domath( char *str )
   return math_out_str;
 }
 
+void *mtc_compile( char *str )
+/*======================================================================
+?  Parse the given string to an operations list that may be evaluated
+|  repeatedly with mtc_evalcode() without parsing the string again.
+|  The list does not refer to any thread specific data. Strings
+|  defining functions or making system calls are not compiled, as
+|  their evaluation modifies the list or has side effects.
+|
+=  the operations list, or NULL if the string could not be compiled
+&  doparse(), free_clause()
+~  mtc_evalcode(), mtc_domath()
+^=====================================================================*/
+{
+  CLAUSE *root = NULL, *ptr;
+
+  jmp_buf jmp, *savejmp;         /* save program context */
+
+  if ( !str || !*str ) return NULL;
+
+  savejmp = jmpbuf;
+  jmpbuf = &jmp;
+
+  if ( math_out_str ) math_out_str[0] = '\0';
+  math_out_count  = 0;
+
+  ALLOC_HEAD = (LIST *)NULL;
+
+  if ( setjmp(*jmpbuf) == 0 )
+  {
+    root = doparse( str );
+
+    for( ptr = root; ptr; ptr = LINK(ptr) )
+    {
+      if ( ptr->data == funcsym || ptr->data == systemcall )
+      {
+        free_clause( root );
+        root = NULL;
+        break;
+      }
+    }
+  }
+
+  /*
+   *  the list must not be freed by a later error()
+   */
+  ALLOC_HEAD = (LIST *)NULL;
+
+  jmpbuf = savejmp;
+
+  return root;
+}
+
+void mtc_setvar( char *name, double *values, int n )
+/*======================================================================
+?  Set global VARIABLE name to the 1 x n matrix given by values. The
+|  existing matrix is reused if it is of the right size and not shared.
+|
+&  var_check(), var_new()
+^=====================================================================*/
+{
+  VARIABLE *var;
+
+  ALLOC_HEAD = (LIST *)NULL;
+
+  var = (VARIABLE *)lst_find( VARIABLES, name );
+  if ( !var || TYPE(var) != TYPE_DOUBLE || REFCNT(var) != 1 ||
+       NROW(var) != 1 || NCOL(var) != n )
+  {
+    var = var_new( name, TYPE_DOUBLE, 1, n );
+  }
+  memcpy( MATR(var), values, n*sizeof(double) );
+  var->changed = 1;
+}
+
+int mtc_evalcode( void *code, double *value, char **errmsg )
+/*======================================================================
+?  Evaluate an operations list given by mtc_compile(). Instead of
+|  printing the results the first printed numeric value is returned,
+|  this is what reading the output of mtc_domath() would give.
+|  In case of an error the message is returned in errmsg, as the
+|  output of mtc_domath() would have it.
+|
+=  TRUE if a value was got, FALSE if there was no value and -1 if
+|  there was an error.
+&  evalclause()
+~  mtc_compile(), mtc_domath()
+^=====================================================================*/
+{
+  VARIABLE *headsave;
+
+  jmp_buf jmp, *savejmp;         /* save program context */
+
+  int got = FALSE;
+
+  if ( !code ) return FALSE;
+
+  savejmp = jmpbuf;
+  jmpbuf = &jmp;
+
+  if ( math_out_str ) math_out_str[0] = '\0';
+  math_out_count  = 0;
+
+  ALLOC_HEAD = (LIST *)NULL;
+  headsave = (VARIABLE *)VAR_HEAD;
+
+  math_capture  = TRUE;
+  math_captured = FALSE;
+
+  switch (setjmp(*jmpbuf))
+  {
+    case 0:
+      (void)evalclause( (CLAUSE *)code );
+      got = math_captured;
+    break;
+
+    case 2:
+      VAR_HEAD = (LIST *)headsave;
+      got = -1;
+      if ( errmsg ) *errmsg = math_out_str;
+    break;
+  }
+
+  if ( got > 0 ) *value = math_captured_value;
+
+  math_capture = FALSE;
+  jmpbuf = savejmp;
+
+  return got;
+}
+
 char *doread()
 /*======================================================================
 ?  doread() is really the main loop of this program. Function reads
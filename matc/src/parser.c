@@ -1432,11 +1432,10 @@ void free_clause(root)
     FREEMEM((char *)root);
 }
 
-VARIABLE *doit(line)
+CLAUSE *doparse(line)
 	char *line;
 {
   CLAUSE *ptr, *root;
-  VARIABLE *res;
 
   str = buf;
   strcpy( str, line );
@@ -1454,6 +1453,17 @@ VARIABLE *doit(line)
     }
   }
 
+  return root;
+}
+
+VARIABLE *doit(line)
+	char *line;
+{
+  CLAUSE *root;
+  VARIABLE *res;
+
+  root = doparse(line);
+
 /*  root = optimclause(root); */
 /*  printclause(root, math_out, 0);   */
   res = evalclause(root);
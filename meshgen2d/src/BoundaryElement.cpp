@@ -10,7 +10,10 @@ newTag()
 
 std::ostream& operator<< (std::ostream& o, const BoundaryElement& A)
 {
-	o << A.tag << ' ' << A.edge << ' ' << A.left << ' ' << A.right;
+	int left = A.leftElement != NULL ? A.leftElement->elementId() : A.left;
+	int right = A.rightElement != NULL ? A.rightElement->elementId() : A.right;
+
+	o << A.tag << ' ' << A.edge << ' ' << left << ' ' << right;
 	if (A.c != NULL)
 		o << " 203 " << A.a->tag << ' ' << A.b->tag << ' ' << A.c->tag << '\n';
 	else
@@ -68,6 +68,31 @@ void Connect::initialize()
 	if(!bg->isInitialized()) bg->initialize( nodes, edges );
 }
 
+void Connect::
+prepare()
+{
+	int i, len;
+
+	bounds->collectNodesAndPairs( border, links );
+
+	// Border nodes are shared with the neighbouring bodies
+	len = border.size();
+	for( i = 0; i < len; ++i )
+	{
+		MeshNode *nd = static_cast< MeshNode* >( border[i] );
+		nd->fix();
+	}
+
+	// Shuffle here to draw the random numbers in the same order regardless
+	// of the order in which the bodies are discretized
+	insertOrder.resize( len );
+	for( i = 0; i < len; ++i )
+	{
+		insertOrder[i] = i;
+	}
+	std::random_shuffle(insertOrder.begin(), insertOrder.end());
+}
+
 void Connect::
 discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allElements)
 {
@@ -85,8 +110,6 @@ triangulate()
 	int i;
 	int len;
 	
-	bounds->collectNodesAndPairs( border, links );
-	
 	makeWorld();
 	
 	for (i = 0; i < fixedGeometryNodes.size(); i++)
@@ -99,26 +122,16 @@ triangulate()
 	}
 	
 	len = border.size();
-	int *indirect = new int[len];
-	for( i = 0; i < len; ++i)
-	{
-		indirect[i] = i;
-	}
-	std::random_shuffle(indirect, indirect + len);
 	
 //	std::cout << "Inserting border" << std::endl;
 	for( i = 0; i < len; ++i)
 	{
-		int ind = indirect[i];
+		int ind = insertOrder[i];
 		Vertex *vtx = root->firstAcceptableFound( border[ind]->x, border[ind]->y);
 		addSite( vtx, border[ind], true );
-		MeshNode *nd = static_cast< MeshNode* >( border[ind] );
-		nd->fix();
 		recycle();
 	}
 	
-	delete [] indirect;
-	
 	// Verify borders (no recovery!)
 //	std::cout << "Verifying borders" << std::endl;
 	
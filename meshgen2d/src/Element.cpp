@@ -7,6 +7,9 @@
 #endif
 
 static int nextTag = 1;
+#ifdef _OPENMP
+#pragma omp threadprivate(nextTag)
+#endif
 
 Element::Element()
 {
@@ -20,6 +23,18 @@ newTag()
 	++nextTag;
 }
 
+int Element::
+tagCounter()
+{
+	return nextTag;
+}
+
+void Element::
+setTagCounter(const int t)
+{
+	nextTag = t;
+}
+
 bool Element::isBoundaryConnector( const std::set< std::pair< int, int > > &links ) const
 {
 	int n = 0;
@@ -53,6 +53,7 @@ elements(std::vector< BoundaryElement * >& strip, int direction)
     for( i = 0; i < (nlen - 1); ++i )
     {
       bels.push_back( new BoundaryElement( boundaryTag, nodes[i], nodes[i+1] ) );
+      reversed.push_back( new BoundaryElement( bels.back() ) );
     }
 
     len = bels.size();
@@ -60,12 +61,10 @@ elements(std::vector< BoundaryElement * >& strip, int direction)
 
   if( direction < 0 )
   {
-    for( i = 0; i < len; ++i ) bels[i]->flip( true );
-    std::reverse_copy( bels.begin(), bels.end(), std::back_inserter( strip ) );
+    std::reverse_copy( reversed.begin(), reversed.end(), std::back_inserter( strip ) );
   }
   else
   {
-    for( i = 0; i < len; ++i ) bels[i]->flip( false );
     std::copy( bels.begin(), bels.end(), std::back_inserter( strip ) );
   }
 }
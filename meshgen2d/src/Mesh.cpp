@@ -330,20 +330,70 @@ discretize()
 		if (!ed->isConstant()) ed->discretize( fixedNodes );
 	}
 
+	// Boundary elements are created before the bodies as the inner edges
+	// are shared by two bodies
+	for( eit = geometryEdges.begin(); eit != geometryEdges.end(); ++eit )
+	{
+		GeometryEdge *ed = (*eit).second;
+		ed->elements(boundaryElements, 0);
+	}
+	
+	std::vector< Body * > bodyList;
 	BodyMapIt bit;
 	for( bit = bodies.begin(); bit != bodies.end(); ++bit )
 	{
 		Body *bd = (*bit).second;
-		bd->discretize( fixedNodes, meshNodes, elements );
-		std::cout << "Body " << bd->tag << " completed!" << std::endl;
+		bd->prepare();
+		bodyList.push_back( bd );
 	}
 	
-	for( eit = geometryEdges.begin(); eit != geometryEdges.end(); ++eit )
+	// The bodies only share the already fixed boundary nodes and can be
+	// discretized concurrently. Every body starts numbering its new nodes
+	// and elements from the same tags, the tags are shifted below as if
+	// the bodies were discretized one after another.
+	int i, len = bodyList.size();
+	int nodeBase = MeshNode::tagCounter();
+	int elementBase = Element::tagCounter();
+	std::vector< NodeMap > bodyNodes( len );
+	std::vector< std::list< Element * > > bodyElements( len );
+	std::vector< int > nodeCount( len ), elementCount( len );
+	
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for( i = 0; i < len; ++i )
 	{
-		GeometryEdge *ed = (*eit).second;
-		ed->elements(boundaryElements, 0);
+		MeshNode::setTagCounter( nodeBase );
+		Element::setTagCounter( elementBase );
+		bodyList[i]->discretize( fixedNodes, bodyNodes[i], bodyElements[i] );
+		nodeCount[i] = MeshNode::tagCounter() - nodeBase;
+		elementCount[i] = Element::tagCounter() - elementBase;
+	}
+	
+	int nodeShift = 0, elementShift = 0;
+	for( i = 0; i < len; ++i )
+	{
+		NodeMapIt nit;
+		for( nit = bodyNodes[i].begin(); nit != bodyNodes[i].end(); ++nit )
+		{
+			Node *nd = (*nit).second;
+			if( nd->tag >= nodeBase ) nd->tag += nodeShift;
+			meshNodes[ nd->tag ] = nd;
+		}
+		
+		std::list< Element * >::iterator e;
+		for( e = bodyElements[i].begin(); e != bodyElements[i].end(); ++e )
+			(*e)->shiftTag( elementShift );
+		elements.splice( elements.end(), bodyElements[i] );
+		
+		nodeShift += nodeCount[i];
+		elementShift += elementCount[i];
+		std::cout << "Body " << bodyList[i]->tag << " completed!" << std::endl;
 	}
 	
+	MeshNode::setTagCounter( nodeBase + nodeShift );
+	Element::setTagCounter( elementBase + elementShift );
+	
 	createMiddleNodes();
 
 	std::cout << "Nodes: " << meshNodes.size() << std::endl;
@@ -1,6 +1,9 @@
 #include "MeshNode.h"
 
 static int nextTag = 1;
+#ifdef _OPENMP
+#pragma omp threadprivate(nextTag)
+#endif
 
 MeshNode::MeshNode()
 {
@@ -29,6 +32,18 @@ MeshNode::MeshNode(const int t, const double xc, const double yc)
 	fixed = NEUTRAL;
 }
 
+int MeshNode::
+tagCounter()
+{
+	return nextTag;
+}
+
+void MeshNode::
+setTagCounter(const int t)
+{
+	nextTag = t;
+}
+
 MeshNode::MeshNode(const GeometryNode& nd)
 {
 	tag = nd.tag;
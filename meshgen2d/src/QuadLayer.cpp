@@ -171,7 +171,7 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 	edges[0]->elements(bels, directions[0]);
 	for (j = 0; j < n - 1; j++)
 	{
-		bels[j]->setLeft(elements[j*(m-1)+m-2]->elementId());
+		bels[j]->setLeft(elements[j*(m-1)+m-2]);
 	}
 	
 	bels.clear();
@@ -179,7 +179,7 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 	edges[1]->elements(bels, -directions[1]);
 	for (i = 0; i < m - 1; i++)
 	{
-		bels[i]->setRight(elements[(n-2)*(m-1)+i]->elementId());
+		bels[i]->setRight(elements[(n-2)*(m-1)+i]);
 	}
 	
 	bels.clear();
@@ -187,7 +187,7 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 	edges[2]->elements(bels, -directions[2]);
 	for (j = 0; j < n - 1; j++)
 	{
-		bels[j]->setRight(elements[j*(m-1)]->elementId());
+		bels[j]->setRight(elements[j*(m-1)]);
 	}
 	
 	bels.clear();
@@ -195,7 +195,7 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 	edges[3]->elements(bels, directions[3]);
 	for (i = 0; i < m - 1; i++)
 	{
-		bels[i]->setLeft(elements[i]->elementId());
+		bels[i]->setLeft(elements[i]);
 	}
 	
 	delete [] grid;
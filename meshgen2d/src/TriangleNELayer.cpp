@@ -29,17 +29,17 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 		}
 		
 	delete [] grid;
@@ -68,17 +68,17 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 			
 			t = new TriangleElement( LR, UR, UL);
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 
 	delete [] grid;
@@ -108,17 +108,17 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 		}
 		for( i = m-3; i >= 0; i -= 2 )
 		{
@@ -128,15 +128,15 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 			
 			t = new TriangleElement( LR, UR, UL);
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 	}
 	
@@ -150,15 +150,15 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			
 			t = new TriangleElement( LR, UR, UL);
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 		for( i = m-3; i >= 0; i -= 2 )
 		{
@@ -168,13 +168,13 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 		}
 	}
 
@@ -205,17 +205,17 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 			
 			t = new TriangleElement( LR, UR, UL);
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 		for( i = m-3; i >= 0; i -= 2 )
 		{
@@ -225,15 +225,15 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 		}
 	}
 	
@@ -247,15 +247,15 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 		}
 		for( i = m-3; i >= 0; i -= 2 )
 		{
@@ -268,9 +268,9 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 	}
 
@@ -300,17 +300,17 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 		}
 
 	for( j = 1; j < (n - 1); j += 2 )
@@ -322,15 +322,15 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			
 			t = new TriangleElement( LR, UR, UL);
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 
 	delete [] grid;
@@ -358,17 +358,17 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == 0)
-				bels[3][i]->setLeft(t->elementId());
+				bels[3][i]->setLeft(t);
 			
 			t = new TriangleElement( LR, UR, UL);
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 		}
 
 	for( j = 1; j < (n - 1); j += 2 )
@@ -380,15 +380,15 @@ discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allEle
 			allElements.push_back( t );
 			
 			if (i == m - 2)
-				bels[0][j]->setLeft(t->elementId());
+				bels[0][j]->setLeft(t);
 			if (j == n - 2)
-				bels[1][m - 2 - i]->setLeft(t->elementId());
+				bels[1][m - 2 - i]->setLeft(t);
 			
 			t = new TriangleElement( LL, UR, UL );
 			allElements.push_back( t );
 			
 			if (i == 0)
-				bels[2][n - 2 - j]->setLeft(t->elementId());
+				bels[2][n - 2 - j]->setLeft(t);
 		}
 
 	delete [] grid;
@@ -10,6 +10,9 @@
 #endif
 
 static int nextTag = 1;
+#ifdef _OPENMP
+#pragma omp threadprivate(nextTag)
+#endif
 
 Vertex::Vertex()	: TriangleElement( -1 )
 {
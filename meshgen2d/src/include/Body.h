@@ -9,6 +9,16 @@ class Body
 public:
 	Body(const int t, bool p) { tag = t; parabolic = p; }
 	void addLayer( Layer* l) { layers.push_back( l ); }
+	void prepare()
+	{
+		int len = layers.size();
+		int i;
+		for( i = 0; i < len; ++i )
+		{
+			layers[i]->sanityCheck();
+			layers[i]->prepare();
+		}
+	}
 	void discretize(NodeMap& fixedNodes,  NodeMap& allNodes, std::list< Element* >& allElements)
 	{
 		std::list< Element* > elements;
@@ -16,7 +26,6 @@ public:
 		int i;
 		for( i = 0; i < len; ++i )
 		{
-			layers[i]->sanityCheck();
 			layers[i]->discretize( fixedNodes, allNodes, elements );
 		}
 		
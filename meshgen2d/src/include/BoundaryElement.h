@@ -17,13 +17,29 @@ public:
 		b = n2;
 		c = NULL;
 		left = right = 0;
+		leftElement = rightElement = NULL;
 		flipped = false;
+		owner = this;
 		newTag();
 	}
 	
-	void newTag();
+	// Reversed view of an element. The view is never flipped afterwards, so
+	// bodies on both sides of an inner edge may set their neighbours at the
+	// same time.
+	BoundaryElement( BoundaryElement *e )
+	{
+		edge = e->edge;
+		a = e->a;
+		b = e->b;
+		c = NULL;
+		left = right = 0;
+		leftElement = rightElement = NULL;
+		flipped = true;
+		owner = e;
+		tag = e->tag;
+	}
 	
-	void flip( bool status ) { flipped = status; }
+	void newTag();
 	
 	Vertex* setHolder( Vertex *v ) 
 	{
@@ -32,19 +48,21 @@ public:
 		if( !flipped ) 
 		{
 			holder = v->vertexWith(a, b);
-			left = holder->elementId();
+			owner->leftElement = holder;
 		}
 		else 
 		{
 			holder = v->vertexWith(b, a);
-			right = holder->elementId();
+			owner->rightElement = holder;
 		}
 		
 		return holder;
 	}
 	
-	void setLeft( int id ) { (flipped?right:left) = id; }
-	void setRight( int id ) { (flipped?left:right) = id; }
+	void setLeft( Element *e ) { (flipped?owner->rightElement:owner->leftElement) = e; }
+	void setRight( Element *e ) { (flipped?owner->leftElement:owner->rightElement) = e; }
+	void setLeft( int id ) { (flipped?owner->right:owner->left) = id; }
+	void setRight( int id ) { (flipped?owner->left:owner->right) = id; }
 
 	Node *from() { return a; }
 	Node *to() { return b; }
@@ -56,7 +74,9 @@ private:
 	int edge;
 	Node *a, *b, *c;
 	int left, right;
+	Element *leftElement, *rightElement;
 	bool flipped;
+	BoundaryElement *owner;
 	int tag;
 };
 
@@ -22,6 +22,7 @@ public:
 	~Connect() { }
 
 	virtual void initialize();
+	virtual void prepare();
 	void discretize(NodeMap& fixedNodes, NodeMap& allNodes, std::list< Element* >& allElements);
 	void setBounds( Border *bd ) { bounds = bd; }
 	
@@ -41,6 +42,7 @@ protected:
 	Node *world[4];
 	
 	std::vector< Node* > border;
+	std::vector< int > insertOrder;
 	std::set< std::pair< int, int > > links;
 	
 	std::list< Vertex* > deleted;
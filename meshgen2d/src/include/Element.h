@@ -23,8 +23,13 @@ public:
 	~Element() { };
 	
 	void newTag();
+	void shiftTag( const int offset ) { elementTag += offset; }
 	int elementId() const { return elementTag; }
 	
+	// Next free tag of the calling thread
+	static int tagCounter();
+	static void setTagCounter( const int t );
+	
 	void setBody( const int bd ) { body = bd; }
 	int partOfBody() const { return body; }
 	bool isSameBody( const int bd ) const { return body == bd; }
@@ -79,6 +79,7 @@ protected:
 	edge_type type;
 	
 	std::vector< BoundaryElement * > bels;
+	std::vector< BoundaryElement * > reversed;
 
 	std::vector< BGMesh * > bgMeshes;
 };
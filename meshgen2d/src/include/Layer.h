@@ -42,6 +42,11 @@ public:
 
 	virtual void initialize() = 0;
 
+	// Called serially after the boundaries have been discretized. Anything
+	// touching data shared with other bodies must be done here, since the
+	// bodies are then discretized concurrently.
+	virtual void prepare() { }
+
 	virtual void discretize(NodeMap& fixedNodes, NodeMap& allNodes, 
 		std::list< Element* >& allElements) = 0;
 	virtual void setBounds( Border *bd ) { bounds = bd; }
@@ -14,6 +14,10 @@ public:
 	MeshNode(const GeometryNode& nd);
 	~MeshNode() { }
 	
+	// Next free tag of the calling thread
+	static int tagCounter();
+	static void setTagCounter(const int t);
+	
 	void fix() { fixed = FIXED; }
 	bool isFixed() { return fixed == FIXED; }
 	void putOnCrysralIfNotFixed() { if( fixed != FIXED ) fixed = CRYSTALNODE; }